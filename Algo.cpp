@@ -1,24 +1,374 @@
-
+#include "Arena.h"
 #include "BufferAlgorithm.h"
 #include "Config.h"
+#include "JSON.h"
 #include "RCGraph.h"
+#include "ShiLiAlgorithm.h"
+#include "SoAFrontier.h"
 #include "SolutionInsertion.h"
+#include "SubtreeCache.h"
+#include "ThreadPool.h"
 
+#include <charconv>
 #include <chrono>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
+#include <optional>
+#include <unordered_map>
 
 using namespace algo;
 
-static std::string getOutputFilePath(std::string_view Input) {
+static std::string getOutputFilePath(std::string_view Input,
+                                     std::string_view Suffix = "_out") {
   namespace fs = std::filesystem;
 
   auto InputPath = fs::path{Input};
   auto Stem = InputPath.stem().string();
-  auto ResPath = fs::current_path() / (Stem + "_out.json");
+  auto ResPath = fs::current_path() / (Stem + std::string(Suffix) + ".json");
   return ResPath.string();
 }
 
+enum class EngineKind {
+  VanGinneken,
+  ShiLi,
+};
+
+enum class PrecisionKind {
+  Single,
+  Double,
+  Fixed,
+};
+
+enum class DelayModelKind {
+  Elmore,
+  Lumped,
+};
+
+enum class ModeKind {
+  Single,
+  Batch,
+  Convert,
+};
+
+struct OptionsTy {
+  ModeKind Mode = ModeKind::Single;
+  EngineKind Engine = EngineKind::VanGinneken;
+  PrecisionKind Precision = PrecisionKind::Single;
+  DelayModelKind DelayModel = DelayModelKind::Elmore;
+  CandidatePolicyTy Candidates;
+  ApproximationTy Approximation;
+  unsigned Threads = 1;
+  unsigned Grain = 4096;
+  // Budget of the subtree cache, 0 solves every subtree.
+  size_t SubtreeCacheBytes = 0;
+  // Writes the root trade-off between RAT, buffers and area, TradeOffSize
+  // solutions of it with the best RAT or all of them if 0.
+  bool TradeOff = false;
+  unsigned TradeOffSize = 0;
+  // Looks for the cheapest solution that meets TargetRAT instead of the one
+  // with the best RAT.
+  std::optional<double> TargetRAT;
+  BufferCostKind Cost = BufferCostKind::Count;
+  // Indentation of written JSON nets, 0 writes them on a single line.
+  unsigned JSONIndent = 4;
+  std::string TechFile;
+  // Single net, or a manifest or a directory of nets in batch mode.
+  std::string TestFile;
+  // Converted net, JSON if it ends with .json and binary otherwise.
+  std::string OutputFile;
+};
+
+static std::string usage(std::string_view Prog) {
+  std::string Options =
+      " [--engine=van-ginneken|shi-li] [--threads=N] [--grain=N] [--compact]"
+      " [--huge-pages] [--simd=scalar|sse|avx2]"
+      " [--precision=float|double|fixed] [--delay=elmore|lumped]"
+      " [--candidates=step:N|max:N|bends:N|relative:F]"
+      " [--subtree-cache[=MB]] [--rat-tolerance=X] [--cap-bucket=X]"
+      " [--pareto[=K]] [--target-rat=X] [--minimize=buffers|area]";
+  return "Usage: " + std::string(Prog) + Options +
+         " <technology_file_name>.json <test_name>.json\n"
+         "       " +
+         std::string(Prog) + " batch" + Options +
+         " <technology_file_name>.json <manifest_or_directory>\n"
+         "       " +
+         std::string(Prog) + " convert [--compact] <input_net> <output_net>";
+}
+
+static EngineKind parseEngine(std::string_view Name) {
+  if (Name == "van-ginneken")
+    return EngineKind::VanGinneken;
+  if (Name == "shi-li")
+    return EngineKind::ShiLi;
+  throw std::runtime_error("unknown engine " + std::string(Name));
+}
+
+static PrecisionKind parsePrecision(std::string_view Name) {
+  if (Name == "float")
+    return PrecisionKind::Single;
+  if (Name == "double")
+    return PrecisionKind::Double;
+  if (Name == "fixed")
+    return PrecisionKind::Fixed;
+  throw std::runtime_error("unknown precision " + std::string(Name));
+}
+
+static DelayModelKind parseDelayModel(std::string_view Name) {
+  if (Name == "elmore")
+    return DelayModelKind::Elmore;
+  if (Name == "lumped")
+    return DelayModelKind::Lumped;
+  throw std::runtime_error("unknown delay model " + std::string(Name));
+}
+
+static unsigned parseUnsigned(std::string_view Name, std::string_view Value) {
+  unsigned Res = 0;
+  auto [Ptr, Err] = std::from_chars(Value.begin(), Value.end(), Res);
+  if (Err != std::errc{} || Ptr != Value.end() || Res == 0)
+    throw std::runtime_error(std::string(Name) + " expects a positive number");
+  return Res;
+}
+
+static double parseNonNegative(std::string_view Name, std::string_view Value) {
+  double Res = 0;
+  auto [Ptr, Err] = std::from_chars(Value.begin(), Value.end(), Res);
+  if (Err != std::errc{} || Ptr != Value.end() || !(Res >= 0))
+    throw std::runtime_error(std::string(Name) +
+                             " expects a non-negative number");
+  return Res;
+}
+
+static double parseDouble(std::string_view Name, std::string_view Value) {
+  double Res = 0;
+  auto [Ptr, Err] = std::from_chars(Value.begin(), Value.end(), Res);
+  if (Err != std::errc{} || Ptr != Value.end() || !std::isfinite(Res))
+    throw std::runtime_error(std::string(Name) + " expects a number");
+  return Res;
+}
+
+static BufferCostKind parseCost(std::string_view Name) {
+  if (Name == "buffers")
+    return BufferCostKind::Count;
+  if (Name == "area")
+    return BufferCostKind::Area;
+  throw std::runtime_error("unknown buffer cost " + std::string(Name));
+}
+
+// Policy written as <kind>:<value>.
+static CandidatePolicyTy parseCandidatePolicy(std::string_view Policy) {
+  auto Colon = Policy.find(':');
+  auto Kind = Policy.substr(0, Colon);
+  auto Value = Colon == Policy.npos ? std::string_view{}
+                                    : Policy.substr(Colon + 1);
+  if (Kind == "step")
+    return CandidatePolicyTy::step(parseUnsigned("--candidates=step", Value));
+  if (Kind == "max")
+    return CandidatePolicyTy::maxPerEdge(
+        parseUnsigned("--candidates=max", Value));
+  if (Kind == "bends") {
+    if (Value == "0")
+      return CandidatePolicyTy::bends(0);
+    return CandidatePolicyTy::bends(parseUnsigned("--candidates=bends", Value));
+  }
+  if (Kind == "relative") {
+    double Fraction = 0;
+    auto [Ptr, Err] = std::from_chars(Value.begin(), Value.end(), Fraction);
+    if (Err != std::errc{} || Ptr != Value.end() || !(Fraction > 0) ||
+        Fraction > 1)
+      throw std::runtime_error(
+          "--candidates=relative expects a fraction in (0, 1]");
+    return CandidatePolicyTy::relative(Fraction);
+  }
+  throw std::runtime_error("unknown candidate policy " + std::string(Policy));
+}
+
+static OptionsTy parseOptions(int argc, const char *argv[]) {
+  OptionsTy Opts;
+  std::vector<std::string_view> Positional;
+  int First = 1;
+  if (argc > 1 && std::string_view{argv[1]} == "batch") {
+    Opts.Mode = ModeKind::Batch;
+    ++First;
+  } else if (argc > 1 && std::string_view{argv[1]} == "convert") {
+    Opts.Mode = ModeKind::Convert;
+    ++First;
+  }
+  for (int Idx = First; Idx < argc; ++Idx) {
+    std::string_view Arg = argv[Idx];
+    if (!Arg.starts_with("--")) {
+      Positional.push_back(Arg);
+      continue;
+    }
+    auto Eq = Arg.find('=');
+    auto Name = Arg.substr(0, Eq);
+    auto Value = Eq == Arg.npos ? std::string_view{} : Arg.substr(Eq + 1);
+    if (Name == "--engine")
+      Opts.Engine = parseEngine(Value);
+    else if (Name == "--threads")
+      Opts.Threads = parseUnsigned(Name, Value);
+    else if (Name == "--grain")
+      Opts.Grain = parseUnsigned(Name, Value);
+    else if (Arg == "--compact")
+      Opts.JSONIndent = 0;
+    else if (Arg == "--huge-pages")
+      Arena::setUseHugePages(true);
+    else if (Name == "--simd")
+      setSIMDLevel(parseSIMDLevel(Value));
+    else if (Name == "--precision")
+      Opts.Precision = parsePrecision(Value);
+    else if (Name == "--delay")
+      Opts.DelayModel = parseDelayModel(Value);
+    else if (Name == "--candidates")
+      Opts.Candidates = parseCandidatePolicy(Value);
+    else if (Name == "--subtree-cache")
+      Opts.SubtreeCacheBytes =
+          Value.empty() ? SubtreeCache::DefaultBudget
+                        : size_t{parseUnsigned(Name, Value)} << 20;
+    else if (Name == "--rat-tolerance")
+      Opts.Approximation.RATTolerance = parseNonNegative(Name, Value);
+    else if (Name == "--cap-bucket")
+      Opts.Approximation.CapacityBucket = parseNonNegative(Name, Value);
+    else if (Name == "--pareto") {
+      Opts.TradeOff = true;
+      Opts.TradeOffSize = Value.empty() ? 0 : parseUnsigned(Name, Value);
+    } else if (Name == "--target-rat")
+      Opts.TargetRAT = parseDouble(Name, Value);
+    else if (Name == "--minimize")
+      Opts.Cost = parseCost(Value);
+    else
+      throw std::runtime_error("unknown option " + std::string(Arg) + "\n" +
+                               usage(argv[0]));
+  }
+  if (Positional.size() != 2)
+    throw std::runtime_error(usage(argv[0]));
+  if (Opts.Mode == ModeKind::Convert) {
+    Opts.TestFile = Positional[0];
+    Opts.OutputFile = Positional[1];
+    return Opts;
+  }
+  Opts.TechFile = Positional[0];
+  Opts.TestFile = Positional[1];
+  if (Opts.Mode == ModeKind::Single && Opts.Engine == EngineKind::ShiLi &&
+      Opts.Threads != 1)
+    throw std::runtime_error("shi-li engine does not support --threads");
+  if (Opts.Engine == EngineKind::ShiLi &&
+      (Opts.Precision != PrecisionKind::Single ||
+       Opts.DelayModel != DelayModelKind::Elmore))
+    throw std::runtime_error(
+        "shi-li engine supports only --precision=float --delay=elmore");
+  if (Opts.Engine == EngineKind::ShiLi && Opts.SubtreeCacheBytes != 0)
+    throw std::runtime_error("shi-li engine does not support --subtree-cache");
+  if (Opts.Engine == EngineKind::ShiLi && !Opts.Approximation.isExact())
+    throw std::runtime_error(
+        "shi-li engine does not support --rat-tolerance and --cap-bucket");
+  if (Opts.TradeOff &&
+      (Opts.Engine == EngineKind::ShiLi || Opts.SubtreeCacheBytes != 0 ||
+       !Opts.Approximation.isExact()))
+    throw std::runtime_error("--pareto supports only the van-ginneken engine "
+                             "without --subtree-cache and approximation");
+  if (Opts.TradeOff && Opts.Mode == ModeKind::Single && Opts.Threads != 1)
+    throw std::runtime_error("--pareto does not support --threads");
+  if (Opts.TargetRAT &&
+      (Opts.Engine == EngineKind::ShiLi || Opts.SubtreeCacheBytes != 0 ||
+       !Opts.Approximation.isExact() || Opts.TradeOff))
+    throw std::runtime_error(
+        "--target-rat supports only the van-ginneken engine without "
+        "--subtree-cache, approximation and --pareto");
+  if (Opts.TargetRAT && Opts.Mode == ModeKind::Single && Opts.Threads != 1)
+    throw std::runtime_error("--target-rat does not support --threads");
+  return Opts;
+}
+
+// With TradeOff, the whole trade-off is solved into it and the solution with
+// the best RAT is returned.
+template <typename NumericT, typename DelayModelT>
+static SolutionTy runVanGinneken(const OptionsTy &Opts, const RCGraphTy &G,
+                                 ThreadPool *Pool, SubtreeCache *Cache,
+                                 EngineStatsTy &Stats, TradeOffTy *TradeOff) {
+  if (TradeOff) {
+    *TradeOff =
+        bufferTradeOff<NumericT, DelayModelT>(G, Opts.Candidates, &Stats);
+    return TradeOff->front().Solution;
+  }
+  if (Opts.TargetRAT)
+    return minimumBuffers<NumericT, DelayModelT>(G, *Opts.TargetRAT, Opts.Cost,
+                                                 Opts.Candidates, &Stats);
+  if (!Pool)
+    return bufferInsertion<NumericT, DelayModelT>(
+        G, Opts.Candidates, Opts.Approximation, &Stats, Cache);
+  return bufferInsertion<NumericT, DelayModelT>(G, *Pool, Opts.Grain,
+                                                Opts.Candidates,
+                                                Opts.Approximation, &Stats,
+                                                Cache);
+}
+
+template <typename NumericT>
+static SolutionTy runVanGinneken(const OptionsTy &Opts, const RCGraphTy &G,
+                                 ThreadPool *Pool, SubtreeCache *Cache,
+                                 EngineStatsTy &Stats, TradeOffTy *TradeOff) {
+  switch (Opts.DelayModel) {
+  case DelayModelKind::Elmore:
+    return runVanGinneken<NumericT, ElmoreDelay>(Opts, G, Pool, Cache, Stats,
+                                                 TradeOff);
+  case DelayModelKind::Lumped:
+    return runVanGinneken<NumericT, LumpedDelay>(Opts, G, Pool, Cache, Stats,
+                                                 TradeOff);
+  }
+  throw std::runtime_error("Unknown DelayModelKind");
+}
+
+// Subtrees of the net are solved on Pool if there is one, and reused from
+// Cache if there is one. TradeOff is filled if the options ask for it.
+static SolutionTy runEngine(const OptionsTy &Opts, const RCGraphTy &G,
+                            ThreadPool *Pool, SubtreeCache *Cache,
+                            EngineStatsTy &Stats, TradeOffTy &TradeOff) {
+  auto *Curve = Opts.TradeOff ? &TradeOff : nullptr;
+  switch (Opts.Engine) {
+  case EngineKind::VanGinneken:
+    switch (Opts.Precision) {
+    case PrecisionKind::Single:
+      return runVanGinneken<SingleNumeric>(Opts, G, Pool, Cache, Stats, Curve);
+    case PrecisionKind::Double:
+      return runVanGinneken<DoubleNumeric>(Opts, G, Pool, Cache, Stats, Curve);
+    case PrecisionKind::Fixed:
+      return runVanGinneken<FixedNumeric>(Opts, G, Pool, Cache, Stats, Curve);
+    }
+    throw std::runtime_error("Unknown PrecisionKind");
+  case EngineKind::ShiLi:
+    return shiLiBufferInsertion(G, Opts.Candidates, &Stats);
+  }
+  throw std::runtime_error("Unknown EngineKind");
+}
+
+// Solutions of the trade-off with the best RAT, as JSON.
+static void writeTradeOff(const OptionsTy &Opts, const TradeOffTy &TradeOff,
+                          std::ostream &OS) {
+  auto Size = TradeOff.size();
+  if (Opts.TradeOffSize != 0)
+    Size = std::min<size_t>(Size, Opts.TradeOffSize);
+  auto SolutionArr = nlohmann::ordered_json::array();
+  for (const auto &Point : std::span{TradeOff}.first(Size)) {
+    auto BufferArr = nlohmann::ordered_json::array();
+    for (const auto &Candidate : Point.Solution) {
+      if (!Candidate.HasBuffer)
+        continue;
+      BufferArr.push_back({{"x", Candidate.P.X},
+                           {"y", Candidate.P.Y},
+                           {"edge", Candidate.EId},
+                           {"name", Candidate.Buffer->Name}});
+    }
+    SolutionArr.push_back({{"rat", Point.RAT},
+                           {"buffers", Point.Buffers},
+                           {"area", Point.Area},
+                           {"buffer", std::move(BufferArr)}});
+  }
+  nlohmann::ordered_json DataObj;
+  DataObj["solution"] = std::move(SolutionArr);
+  OS << DataObj.dump(Opts.JSONIndent == 0 ? -1 : Opts.JSONIndent) << "\n";
+}
+
 static SolutionTy extractSolution(const SolutionTy &Candidates) {
   auto Solution = SolutionTy{};
   std::copy_if(Candidates.begin(), Candidates.end(),
@@ -31,23 +381,193 @@ static NodeTy::FloatTy resultingRAT(const SolutionTy &Solution) {
   return Solution.back().RAT;
 }
 
+// Nets listed in a manifest, one path per line relative to the manifest,
+// or every net of a directory. Empty lines and lines starting with '#' are
+// skipped, so are the technology file and outputs of earlier runs.
+static std::vector<std::string> listNets(const OptionsTy &Opts) {
+  namespace fs = std::filesystem;
+
+  std::vector<std::string> Nets;
+  auto ListPath = fs::path{Opts.TestFile};
+  if (fs::is_directory(ListPath)) {
+    for (auto &&Entry : fs::directory_iterator{ListPath}) {
+      const auto &Path = Entry.path();
+      if (!Entry.is_regular_file() ||
+          (Path.extension() != ".json" && Path.extension() != ".rcg") ||
+          Path.stem().string().ends_with("_out") ||
+          Path.stem().string().ends_with("_pareto") ||
+          fs::equivalent(Path, Opts.TechFile))
+        continue;
+      Nets.push_back(Path.string());
+    }
+    std::sort(Nets.begin(), Nets.end());
+  } else {
+    std::ifstream ListIS{ListPath};
+    if (!ListIS)
+      throw std::runtime_error("cannot open " + Opts.TestFile);
+    std::string Line;
+    while (std::getline(ListIS, Line)) {
+      auto Begin = Line.find_first_not_of(" \t\r");
+      if (Begin == Line.npos || Line[Begin] == '#')
+        continue;
+      auto End = Line.find_last_not_of(" \t\r");
+      auto NetPath = fs::path{Line.substr(Begin, End - Begin + 1)};
+      Nets.push_back((ListPath.parent_path() / NetPath).string());
+    }
+  }
+
+  // Every net writes <stem>_out.json to the current directory.
+  std::unordered_map<std::string, std::string_view> Outputs;
+  for (auto &&Net : Nets) {
+    auto [It, Inserted] = Outputs.emplace(getOutputFilePath(Net), Net);
+    if (!Inserted)
+      throw std::runtime_error("nets " + std::string(It->second) + " and " +
+                               Net + " are both written to " + It->first);
+  }
+  return Nets;
+}
+
+struct NetResultTy {
+  NodeTy::FloatTy RAT = 0;
+  size_t Buffers = 0;
+  EngineStatsTy Stats;
+  std::chrono::milliseconds AlgoTime{0};
+  std::chrono::milliseconds Time{0};
+  std::string Error;
+};
+
+static NetResultTy solveNet(const OptionsTy &Opts, const Config &Cfg,
+                            SubtreeCache *Cache, const std::string &TestFile) {
+  using namespace std::chrono;
+
+  NetResultTy Res;
+  auto Start = high_resolution_clock::now();
+  auto G = loadRCGraph(TestFile);
+  G.setAttrs(Config{Cfg});
+  auto AlgoStart = high_resolution_clock::now();
+  TradeOffTy TradeOff;
+  auto Candidates = runEngine(Opts, G, nullptr, Cache, Res.Stats, TradeOff);
+  Res.AlgoTime =
+      duration_cast<milliseconds>(high_resolution_clock::now() - AlgoStart);
+  if (Opts.TradeOff) {
+    std::ofstream TradeOffOS{getOutputFilePath(TestFile, "_pareto")};
+    writeTradeOff(Opts, TradeOff, TradeOffOS);
+  }
+  auto Solution = extractSolution(Candidates);
+  Res.RAT = resultingRAT(Candidates);
+  Res.Buffers = Solution.size();
+
+  insertSolution(Solution, G);
+  std::ofstream OS{getOutputFilePath(TestFile)};
+  writeRCGraph(G, OS, Opts.JSONIndent);
+  Res.Time = duration_cast<milliseconds>(high_resolution_clock::now() - Start);
+  return Res;
+}
+
+// Solves every net on its own thread of the pool and prints a summary.
+// Returns the number of nets that failed.
+static size_t runBatch(const OptionsTy &Opts) {
+  using namespace std::chrono;
+
+  auto Start = high_resolution_clock::now();
+  std::ifstream CfgIS{Opts.TechFile};
+  auto Cfg = readConfig(CfgIS);
+  auto Nets = listNets(Opts);
+  std::unique_ptr<SubtreeCache> Cache;
+  if (Opts.SubtreeCacheBytes != 0)
+    Cache = std::make_unique<SubtreeCache>(Opts.SubtreeCacheBytes);
+
+  std::vector<NetResultTy> Results(Nets.size());
+  {
+    ThreadPool Pool{Opts.Threads};
+    for (size_t Idx = 0; Idx != Nets.size(); ++Idx)
+      Pool.submit([&, Idx] {
+        try {
+          Results[Idx] = solveNet(Opts, Cfg, Cache.get(), Nets[Idx]);
+        } catch (const std::exception &E) {
+          Results[Idx].Error = E.what();
+        }
+      });
+    Pool.wait();
+  }
+  auto Duration = duration_cast<milliseconds>(high_resolution_clock::now() -
+                                              Start);
+
+  size_t Failed = 0;
+  std::cout << std::left << std::setw(40) << "Net" << std::right
+            << std::setw(14) << "RAT" << std::setw(10) << "Buffers"
+            << std::setw(10) << "AlgoTime" << std::setw(10) << "Time"
+            << std::setw(14) << "PeakBytes" << "\n";
+  for (size_t Idx = 0; Idx != Nets.size(); ++Idx) {
+    const auto &Res = Results[Idx];
+    std::cout << std::left << std::setw(40) << Nets[Idx] << std::right;
+    if (!Res.Error.empty()) {
+      std::cout << "  FAILED: " << Res.Error << "\n";
+      ++Failed;
+      continue;
+    }
+    std::cout << std::setw(14) << Res.RAT << std::setw(10) << Res.Buffers
+              << std::setw(10) << Res.AlgoTime.count() << std::setw(10)
+              << Res.Time.count() << std::setw(14)
+              << Res.Stats.PeakFrontierBytes << "\n";
+  }
+  std::cout << "Nets = " << Nets.size() << ", Failed = " << Failed
+            << ", Threads = " << Opts.Threads
+            << ", WallTime = " << Duration.count() << std::endl;
+  if (Opts.TargetRAT) {
+    auto Missed = std::count_if(Results.begin(), Results.end(), [&](auto &Res) {
+      return Res.Error.empty() && Res.RAT < *Opts.TargetRAT;
+    });
+    std::cout << "Nets missing the target RAT = " << Missed << std::endl;
+  }
+  if (Cache) {
+    auto CacheStats = Cache->getStats();
+    std::cout << "SubtreeCache: Subtrees = " << CacheStats.Subtrees
+              << ", Frontiers = " << CacheStats.Frontiers
+              << ", Hits = " << CacheStats.Hits
+              << ", Bytes = " << CacheStats.Bytes << std::endl;
+  }
+  return Failed;
+}
+
+static void convertNet(const OptionsTy &Opts) {
+  auto G = loadRCGraph(Opts.TestFile);
+  if (std::filesystem::path{Opts.OutputFile}.extension() == ".json") {
+    std::ofstream OS{Opts.OutputFile};
+    writeRCGraph(G, OS, Opts.JSONIndent);
+  } else {
+    std::ofstream OS{Opts.OutputFile, std::ios::binary};
+    writeRCGraphBinary(G, OS);
+  }
+}
+
 int main(int argc, const char *argv[]) {
   using namespace std::chrono;
 
   try {
-    if (argc != 3) {
-      throw std::runtime_error("Usage: " + std::string(argv[0]) +
-                               " <technology_file_name>.json <test_name>.json");
+    auto Opts = parseOptions(argc, argv);
+    if (Opts.Mode == ModeKind::Batch)
+      return runBatch(Opts) == 0 ? 0 : 1;
+    if (Opts.Mode == ModeKind::Convert) {
+      convertNet(Opts);
+      return 0;
     }
-    std::string TechFile = argv[1];
-    std::ifstream CfgIS{TechFile};
+
+    std::ifstream CfgIS{Opts.TechFile};
     auto Cfg = readConfig(CfgIS);
-    std::string TestFile = argv[2];
-    std::ifstream TestIS{TestFile};
-    auto G = readRCGraph(TestIS);
+    auto G = loadRCGraph(Opts.TestFile);
     G.setAttrs(std::move(Cfg));
+    std::unique_ptr<ThreadPool> Pool;
+    if (Opts.Threads != 1)
+      Pool = std::make_unique<ThreadPool>(Opts.Threads);
+    std::unique_ptr<SubtreeCache> Cache;
+    if (Opts.SubtreeCacheBytes != 0)
+      Cache = std::make_unique<SubtreeCache>(Opts.SubtreeCacheBytes);
+    EngineStatsTy Stats;
     auto start = high_resolution_clock::now();
-    auto Candidates = bufferInsertion(G);
+    TradeOffTy TradeOff;
+    auto Candidates =
+        runEngine(Opts, G, Pool.get(), Cache.get(), Stats, TradeOff);
     auto end = high_resolution_clock::now();
     auto duration = duration_cast<milliseconds>(end - start);
     auto Solution = extractSolution(Candidates);
@@ -60,11 +580,29 @@ int main(int argc, const char *argv[]) {
     NodeTy::FloatTy RAT = resultingRAT(Candidates);
     std::cout << "Resulting RAT = " << RAT << std::endl;
     std::cout << "Resulting AlgoTime = " << duration.count() << std::endl;
+    std::cout << "Peak frontier bytes = " << Stats.PeakFrontierBytes
+              << std::endl;
+    std::cout << "Candidate records = " << Stats.Records.Allocations << " ("
+              << Stats.Records.BytesUsed << " bytes, "
+              << Stats.Records.BytesReserved << " reserved in "
+              << Stats.Records.Blocks << " blocks)" << std::endl;
+    if (Cache)
+      std::cout << "Reused subtrees = " << Stats.ReusedSubtrees << std::endl;
+    if (!Opts.Approximation.isExact())
+      std::cout << "RAT loss bound = " << Stats.RATLossBound << std::endl;
+    if (Opts.TargetRAT && RAT < *Opts.TargetRAT)
+      std::cout << "Target RAT " << *Opts.TargetRAT << " is not met"
+                << std::endl;
+    if (Opts.TradeOff) {
+      std::cout << "Trade-off solutions = " << TradeOff.size() << std::endl;
+      std::ofstream TradeOffOS{getOutputFilePath(Opts.TestFile, "_pareto")};
+      writeTradeOff(Opts, TradeOff, TradeOffOS);
+    }
 
     insertSolution(Solution, G);
-    auto OutputPath = getOutputFilePath(TestFile);
+    auto OutputPath = getOutputFilePath(Opts.TestFile);
     std::ofstream OS{OutputPath};
-    writeRCGraph(G, OS);
+    writeRCGraph(G, OS, Opts.JSONIndent);
     return 0;
   } catch (const std::exception &E) {
     std::cerr << E.what() << std::endl;
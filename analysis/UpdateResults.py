@@ -1,6 +1,5 @@
 import subprocess
 import os
-import fnmatch
 from pathlib import Path
 
 repo_path = Path(__file__).parent.parent
@@ -23,18 +22,15 @@ def run_command(cmd: list[str]) -> str:
 
 
 def update_results() -> None:
-    test_paths: list[Path] = []
-    for filename in os.listdir(tests_dir_path):
-        if fnmatch.fnmatch(filename, "test*.json"):
-            test_paths.append(tests_dir_path / filename)
     results_dir_path.mkdir(exist_ok=True)
-    for test_path in test_paths:
-        cmd = [
-            f"{prog_path}",
-            f"{tech_path}",
-            f"{test_path}",
-        ]
-        run_command(cmd)
+    cmd = [
+        f"{prog_path}",
+        "batch",
+        f"--threads={os.cpu_count() or 1}",
+        f"{tech_path}",
+        f"{tests_dir_path}",
+    ]
+    print(run_command(cmd), end="")
 
 
 def main():
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace algo {
+
+struct ArenaStatsTy {
+  // Since the last reset.
+  size_t Allocations = 0;
+  size_t BytesUsed = 0;
+  // Blocks are kept across resets and freed with the arena.
+  size_t Blocks = 0;
+  size_t BytesReserved = 0;
+  size_t Resets = 0;
+
+  ArenaStatsTy &operator+=(const ArenaStatsTy &RHS) {
+    Allocations += RHS.Allocations;
+    BytesUsed += RHS.BytesUsed;
+    Blocks += RHS.Blocks;
+    BytesReserved += RHS.BytesReserved;
+    Resets += RHS.Resets;
+    return *this;
+  }
+};
+
+// Monotonic bump allocator. Memory is handed out from large blocks and only
+// given back all at once: reset() rewinds to the first block in O(1) and
+// keeps the blocks for the next user. Objects are never destroyed, so only
+// trivially destructible types may be created in an arena.
+class Arena final {
+  struct BlockTy {
+    std::byte *Data;
+    size_t Size;
+    bool HugePages;
+  };
+
+  std::vector<BlockTy> Blocks;
+  size_t Current = 0;
+  std::byte *Ptr = nullptr;
+  std::byte *End = nullptr;
+  size_t BlockSize;
+  ArenaStatsTy Stats;
+
+  void *allocateSlow(size_t Size, size_t Align);
+
+public:
+  static constexpr size_t DefaultBlockSize = size_t{1} << 20;
+
+  explicit Arena(size_t BlockSize = DefaultBlockSize) : BlockSize{BlockSize} {}
+  ~Arena();
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  // Blocks allocated from now on are backed by transparent huge pages where
+  // the platform supports it.
+  static void setUseHugePages(bool Use);
+
+  void *allocate(size_t Size, size_t Align) {
+    auto Space = static_cast<size_t>(End - Ptr);
+    void *Res = Ptr;
+    if (!Ptr || !std::align(Align, Size, Res, Space))
+      return allocateSlow(Size, Align);
+    Ptr = static_cast<std::byte *>(Res) + Size;
+    ++Stats.Allocations;
+    Stats.BytesUsed += Size;
+    return Res;
+  }
+
+  template <typename T, typename... ArgsTy> T *create(ArgsTy &&...Args) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<ArgsTy>(Args)...);
+  }
+
+  void reset();
+
+  const ArenaStatsTy &getStats() const { return Stats; }
+};
+
+} // namespace algo
@@ -1,7 +1,11 @@
 #pragma once
 
+#include "Arena.h"
 #include "RCGraph.h"
+#include "TimingPolicy.h"
 
+#include <memory>
+#include <span>
 #include <vector>
 
 namespace algo {
@@ -12,11 +16,13 @@ struct CandidateTy {
   PointTy P;
   EdgeTy::EdgeIdTy EId;
   bool HasBuffer;
+  const Module *Buffer;
 
   CandidateTy(NodeTy::FloatTy capacity, NodeTy::FloatTy rat, PointTy point,
-              EdgeTy::EdgeIdTy eid, bool has_buffer)
-      : Capacity{capacity}, RAT{rat}, P{point}, EId{eid}, HasBuffer{
-                                                              has_buffer} {}
+              EdgeTy::EdgeIdTy eid, bool has_buffer,
+              const Module *buffer = nullptr)
+      : Capacity{capacity}, RAT{rat}, P{point}, EId{eid},
+        HasBuffer{has_buffer}, Buffer{buffer} {}
 
   friend std::ostream &operator<<(std::ostream &os,
                                   const CandidateTy &candidate) {
@@ -25,12 +31,196 @@ struct CandidateTy {
        << "\tCapacity = " << candidate.Capacity << "\n"
        << "\tEdgeId = " << candidate.EId << "\n"
        << "\tINSERT = " << candidate.HasBuffer;
+    if (candidate.Buffer)
+      os << "\n\tModule = " << candidate.Buffer->Name;
     return os;
   }
 };
 
 using SolutionTy = std::vector<CandidateTy>;
 
-SolutionTy bufferInsertion(const RCGraphTy &G, unsigned step = 1);
+// Figures of a finished run, for reporting.
+struct EngineStatsTy {
+  // Largest total size of the frontiers alive at the same time.
+  size_t PeakFrontierBytes = 0;
+  // Arenas that held the candidate records.
+  ArenaStatsTy Records;
+  // Subtrees whose frontier came from a SubtreeCache.
+  size_t ReusedSubtrees = 0;
+  // Most RAT that approximate pruning may have given up, 0 for exact runs.
+  NodeTy::FloatTy RATLossBound = 0;
+};
+
+// Where buffers may be placed along an edge. Whatever the policy, the first
+// node of the edge is always the last candidate.
+struct CandidatePolicyTy {
+  enum class KindTy {
+    // Every Step units of length along each straight segment.
+    Step,
+    // At most Count candidates, evenly spaced over the whole edge.
+    MaxPerEdge,
+    // At every bend and Count more evenly spaced on each straight segment.
+    Bends,
+    // Every Fraction of the edge length along each straight segment, but at
+    // least a unit apart.
+    Relative,
+  };
+
+  KindTy Kind = KindTy::Step;
+  unsigned Step = 1;
+  unsigned Count = 0;
+  double Fraction = 0;
+
+  static CandidatePolicyTy step(unsigned Step) {
+    return {KindTy::Step, Step, 0, 0};
+  }
+
+  static CandidatePolicyTy maxPerEdge(unsigned Count) {
+    return {KindTy::MaxPerEdge, 1, Count, 0};
+  }
+
+  static CandidatePolicyTy bends(unsigned Count) {
+    return {KindTy::Bends, 1, Count, 0};
+  }
+
+  static CandidatePolicyTy relative(double Fraction) {
+    return {KindTy::Relative, 1, 0, Fraction};
+  }
+
+  bool operator==(const CandidatePolicyTy &) const = default;
+};
+
+// Lets the engine drop a frontier entry when another one nearly dominates
+// it: has at most CapacityBucket more capacity and at most RATTolerance less
+// RAT. Each candidate point prunes once, so the loss grows with the number
+// of candidate points on a path. EngineStatsTy::RATLossBound bounds it from
+// what each pass actually dropped, and a buffer never carries more extra
+// capacity than the spread of the frontier it drives.
+struct ApproximationTy {
+  double RATTolerance = 0;
+  double CapacityBucket = 0;
+
+  bool isExact() const { return RATTolerance == 0 && CapacityBucket == 0; }
+
+  bool operator==(const ApproximationTy &) const = default;
+};
+
+// Candidate buffer positions along the edge, from its last node towards the
+// first one, every step units of length.
+PointsTy splitEdge(const EdgeTy &edge, unsigned step);
+
+PointsTy splitEdge(std::span<const PointTy> points, unsigned step);
+
+// Candidate buffer positions along the edge chosen by the policy, from its
+// last node towards the first one.
+PointsTy splitEdge(std::span<const PointTy> points,
+                   const CandidatePolicyTy &policy);
+
+class SubtreeCache;
+
+// NumericT is the arithmetic of the dynamic programming and DelayModelT the
+// delay model of wires and buffers, see TimingPolicy.h. Both are fixed at
+// compile time, so the inner loop does not dispatch on them. Instantiated for
+// SingleNumeric, DoubleNumeric and FixedNumeric with ElmoreDelay and
+// LumpedDelay. FixedNumeric runs throw std::overflow_error if a value leaves
+// its range.
+//
+// With a cache, frontiers of subtrees solved before, by this run or by any
+// other run sharing the cache, are reused, see SubtreeCache.h.
+template <typename NumericT = SingleNumeric, typename DelayModelT = ElmoreDelay>
+SolutionTy bufferInsertion(const RCGraphTy &G,
+                           const CandidatePolicyTy &candidates = {},
+                           const ApproximationTy &approximation = {},
+                           EngineStatsTy *stats = nullptr,
+                           SubtreeCache *cache = nullptr);
+
+class ThreadPool;
+
+// Same result as the sequential version. Sibling subtrees are solved
+// concurrently on the pool, subtrees with at most grain units of work are
+// left to a single task.
+template <typename NumericT = SingleNumeric, typename DelayModelT = ElmoreDelay>
+SolutionTy bufferInsertion(const RCGraphTy &G, ThreadPool &pool,
+                           unsigned grain,
+                           const CandidatePolicyTy &candidates = {},
+                           const ApproximationTy &approximation = {},
+                           EngineStatsTy *stats = nullptr,
+                           SubtreeCache *cache = nullptr);
+
+// Root solution of a trade-off run.
+struct TradeOffPointTy {
+  NodeTy::FloatTy RAT;
+  unsigned Buffers;
+  NodeTy::FloatTy Area;
+  // Buffers followed by the root candidate, as bufferInsertion returns them.
+  SolutionTy Solution;
+};
+
+using TradeOffTy = std::vector<TradeOffPointTy>;
+
+// Solves G once, keeping at every node a frontier for each number of buffers
+// and total buffer area below it, and returns the root solutions that no
+// other one beats on RAT, number of buffers and total buffer area at once, by
+// decreasing RAT. The first one has the RAT of bufferInsertion. An entry is
+// only pruned by one that costs at most as much in both, so the trade-off is
+// complete, but with buffers of different areas a node keeps a frontier for
+// every mix of them and the run is much slower than with a single area.
+template <typename NumericT = SingleNumeric, typename DelayModelT = ElmoreDelay>
+TradeOffTy bufferTradeOff(const RCGraphTy &G,
+                          const CandidatePolicyTy &candidates = {},
+                          EngineStatsTy *stats = nullptr);
+
+enum class BufferCostKind {
+  Count,
+  Area,
+};
+
+// Solution with the fewest buffers, or the least total buffer area, whose
+// RAT at the driver is at least target. The net is solved like
+// bufferTradeOff, except that entries that no buffer can bring up to target
+// are dropped as soon as they appear and that layers are told apart by the
+// cost minimized alone. Counting buffers, the first pass keeps a single
+// layer and later ones only as many as the best solution so far needs, so
+// nets that meet the target with few buffers stop after a pass or two.
+// Minimizing area takes a single pass. If no solution meets the target, the
+// one of bufferInsertion is returned.
+template <typename NumericT = SingleNumeric, typename DelayModelT = ElmoreDelay>
+SolutionTy minimumBuffers(const RCGraphTy &G, NodeTy::FloatTy target,
+                          BufferCostKind cost = BufferCostKind::Count,
+                          const CandidatePolicyTy &candidates = {},
+                          EngineStatsTy *stats = nullptr);
+
+// Keeps the frontier of every node of G between solves, so that after a
+// change to a few sinks or edges only the paths from them to the root are
+// solved again. The result is the one of bufferInsertion on the changed
+// graph. G must outlive the object and keep its topology.
+template <typename NumericT = SingleNumeric, typename DelayModelT = ElmoreDelay>
+class IncrementalBufferInsertion final {
+  struct ImplTy;
+  std::unique_ptr<ImplTy> Impl;
+
+public:
+  explicit IncrementalBufferInsertion(
+      RCGraphTy &G, const CandidatePolicyTy &candidates = {},
+      const ApproximationTy &approximation = {});
+  ~IncrementalBufferInsertion();
+
+  IncrementalBufferInsertion(const IncrementalBufferInsertion &) = delete;
+  IncrementalBufferInsertion &
+  operator=(const IncrementalBufferInsertion &) = delete;
+
+  void setSink(NodeTy::NodeIdTy node, NodeTy::FloatTy capacity,
+               NodeTy::FloatTy rat);
+
+  // Points must start at the first node of the edge and end at the last one.
+  void setEdgePoints(EdgeTy::EdgeIdTy edge, PointsTy points);
+
+  // Marks a node whose attributes were changed in the graph directly.
+  void markModified(NodeTy::NodeIdTy node);
+
+  // Solves the nodes changed since the last call and returns the best
+  // solution of the whole net.
+  SolutionTy solve(EngineStatsTy *stats = nullptr);
+};
 
 } // namespace algo
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Arena.h"
+#include "BufferAlgorithm.h"
+#include "RCGraph.h"
+
+#include <type_traits>
+#include <vector>
+
+namespace algo {
+
+// Single buffering decision of a partial solution. Records form an
+// append-only DAG: a Buffer record points to the record of the solution it
+// drives, a Join record glues together the records of two merged subtrees.
+// A null record stands for "no buffers downstream".
+struct CandidateRecordTy {
+  enum class KindTy {
+    Buffer,
+    Join,
+  };
+
+  KindTy Kind;
+  const CandidateRecordTy *Lhs;
+  const CandidateRecordTy *Rhs;
+
+  NodeTy::FloatTy Capacity;
+  NodeTy::FloatTy RAT;
+  PointTy P;
+  EdgeTy::EdgeIdTy EId;
+  const Module *Buffer;
+};
+
+// Frontier entry of the dynamic programming. Everything except the timing
+// pair is shared through the DAG, so entries are cheap to copy. The timing
+// pair is kept in the arithmetic of the engine.
+template <typename FloatT> struct BasicFrontierEntryTy {
+  FloatT Capacity;
+  FloatT RAT;
+  const CandidateRecordTy *Record;
+};
+
+using FrontierEntryTy = BasicFrontierEntryTy<NodeTy::FloatTy>;
+
+template <typename FloatT>
+using BasicFrontierTy = std::vector<BasicFrontierEntryTy<FloatT>>;
+
+using FrontierTy = BasicFrontierTy<NodeTy::FloatTy>;
+
+inline constexpr auto byCapacity = [](const auto &Lhs, const auto &Rhs) {
+  return Lhs.Capacity < Rhs.Capacity;
+};
+
+// Positive iff A lies strictly below the segment from O to B. Fixed-point
+// entries are compared in double: products are exact up to 2^53, beyond that
+// only the choice between nearly collinear vertices may change, and it is
+// still the same on every run.
+template <typename FloatT>
+auto cross(const BasicFrontierEntryTy<FloatT> &O,
+           const BasicFrontierEntryTy<FloatT> &A,
+           const BasicFrontierEntryTy<FloatT> &B) {
+  using CrossTy =
+      std::conditional_t<std::is_integral_v<FloatT>, double, FloatT>;
+  return (CrossTy(A.Capacity) - O.Capacity) * (CrossTy(B.RAT) - O.RAT) -
+         (CrossTy(A.RAT) - O.RAT) * (CrossTy(B.Capacity) - O.Capacity);
+}
+
+// Positions of the upper convex hull vertices of a frontier sorted by
+// capacity. The RAT behind a buffer is linear in the driven entry, so the
+// best entry to drive it is always a hull vertex.
+using HullTy = std::vector<size_t>;
+
+// Records of a DAG live in its arena. Clearing the DAG invalidates every
+// record at once and keeps the memory for the next net.
+class CandidateDAG final {
+  Arena Records;
+
+public:
+  const CandidateRecordTy *addBuffer(const CandidateRecordTy *Downstream,
+                                     NodeTy::FloatTy Capacity,
+                                     NodeTy::FloatTy RAT, PointTy P,
+                                     EdgeTy::EdgeIdTy EId,
+                                     const Module &Buffer) {
+    return Records.create<CandidateRecordTy>(CandidateRecordTy{
+        .Kind = CandidateRecordTy::KindTy::Buffer,
+        .Lhs = Downstream,
+        .Rhs = nullptr,
+        .Capacity = Capacity,
+        .RAT = RAT,
+        .P = P,
+        .EId = EId,
+        .Buffer = &Buffer,
+    });
+  }
+
+  const CandidateRecordTy *join(const CandidateRecordTy *Lhs,
+                                const CandidateRecordTy *Rhs) {
+    if (!Lhs)
+      return Rhs;
+    if (!Rhs)
+      return Lhs;
+    return Records.create<CandidateRecordTy>(CandidateRecordTy{
+        .Kind = CandidateRecordTy::KindTy::Join,
+        .Lhs = Lhs,
+        .Rhs = Rhs,
+        .Capacity = {},
+        .RAT = {},
+        .P = PointTy{0, 0},
+        .EId = RCGraphTy::invalidEdgeId(),
+        .Buffer = nullptr,
+    });
+  }
+
+  // Copy of a record built outside of the DAG.
+  const CandidateRecordTy *add(const CandidateRecordTy &Record) {
+    return Records.create<CandidateRecordTy>(Record);
+  }
+
+  size_t size() const { return Records.getStats().Allocations; }
+
+  void clear() { Records.reset(); }
+
+  const ArenaStatsTy &getStats() const { return Records.getStats(); }
+};
+
+// DAG of the calling thread, cleared. A thread that solves many nets one
+// after another keeps allocating their records from the same memory.
+CandidateDAG &acquireThreadDAG();
+
+// Walks backpointers from Record and returns buffers in the order they were
+// inserted (downstream buffers first).
+SolutionTy collectBuffers(const CandidateRecordTy *Record);
+
+// Buffers of the winning root entry followed by the root candidate itself.
+SolutionTy collectSolution(const FrontierEntryTy &Best, PointTy Root);
+
+void buildHull(const FrontierTy &Frontier, HullTy &Hull);
+
+// Merges the pruned frontiers of two sibling subtrees. The result is pruned.
+FrontierTy mergeFrontiers(const FrontierTy &Lhs, const FrontierTy &Rhs,
+                          CandidateDAG &DAG);
+
+} // namespace algo
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace algo {
 
@@ -21,6 +23,8 @@ struct Module {
   FloatTy R;
   FloatTy C;
   FloatTy K;
+  // Only compared between solutions, buffers without an area count as one.
+  FloatTy Area = 1;
 };
 
 struct Technology final {
@@ -33,7 +37,7 @@ struct Technology final {
 };
 
 class Config final {
-  std::unordered_map<ModuleKind, Module> Modules;
+  std::unordered_map<ModuleKind, std::vector<Module>> Modules;
   Technology Tech;
 
 public:
@@ -42,16 +46,27 @@ public:
   const Technology &getTechnology() const { return Tech; }
 
   void addModule(ModuleKind Kind, Module &&M) {
-    Modules.emplace(Kind, std::move(M));
+    Modules[Kind].push_back(std::move(M));
   }
 
-  const Module &getModule(ModuleKind Kind) const {
+  const std::vector<Module> &getModules(ModuleKind Kind) const {
     auto Found = Modules.find(Kind);
     if (Found == Modules.end()) {
       throw std::runtime_error("there is no such Module");
     }
     return Found->second;
   }
+
+  const Module &getModule(ModuleKind Kind, std::string_view Name) const {
+    const auto &Library = getModules(Kind);
+    auto Found =
+        std::find_if(Library.begin(), Library.end(),
+                     [Name](const Module &M) { return M.Name == Name; });
+    if (Found == Library.end()) {
+      throw std::runtime_error("there is no such Module");
+    }
+    return *Found;
+  }
 };
 
 Config readConfig(std::istream &Is);
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "RCGraph.h"
+
+#include <span>
+#include <vector>
+
+namespace algo {
+
+// Snapshot of the tree hanging from the root of an RCGraph, laid out in
+// compressed sparse rows: child edges of all nodes and points of all edges
+// live in two contiguous arrays. Node and edge ids are the ones of the graph,
+// which must outlive the snapshot and keep its topology.
+class FrozenRCGraph final {
+public:
+  using NodeIdTy = RCGraphTy::NodeIdTy;
+  using EdgeIdTy = RCGraphTy::EdgeIdTy;
+
+private:
+  const RCGraphTy *G;
+
+  std::vector<unsigned> ChildBegin;
+  std::vector<EdgeIdTy> ChildEdges;
+  std::vector<NodeIdTy> ChildNodes;
+  std::vector<EdgeIdTy> Parents;
+  std::vector<NodeIdTy> ParentNodes;
+
+  std::vector<unsigned> PointBegin;
+  std::vector<unsigned> PointEnd;
+  // Room of every edge in Points, at least the points it has.
+  std::vector<unsigned> PointCapacity;
+  PointsTy Points;
+  // Points of slots that edges moved out of.
+  size_t UnusedPoints = 0;
+
+  // Children come before their parents, and every subtree occupies a
+  // contiguous range that ends with its root.
+  std::vector<NodeIdTy> PostOrder;
+  std::vector<unsigned> PostIndex;
+  std::vector<unsigned> SubtreeSize;
+
+  // Drops the slots that edges moved out of.
+  void repackPoints();
+
+public:
+  explicit FrozenRCGraph(const RCGraphTy &G);
+
+  const RCGraphTy &getGraph() const { return *G; }
+
+  const Config &getAttrs() const { return G->getAttrs(); }
+
+  const NodeTy &getNode(NodeIdTy NId) const { return G->getNode(NId); }
+
+  NodeIdTy getRoot() const { return PostOrder.back(); }
+
+  NodeIdTy getNodeIdBound() const { return Parents.size(); }
+
+  size_t getNumNodes() const { return PostOrder.size(); }
+
+  EdgeIdTy getParent(NodeIdTy NId) const { return Parents[NId]; }
+
+  NodeIdTy getParentNode(NodeIdTy NId) const { return ParentNodes[NId]; }
+
+  std::span<const EdgeIdTy> getChildren(NodeIdTy NId) const {
+    return {ChildEdges.data() + ChildBegin[NId],
+            ChildEdges.data() + ChildBegin[NId + 1]};
+  }
+
+  std::span<const NodeIdTy> getChildNodes(NodeIdTy NId) const {
+    return {ChildNodes.data() + ChildBegin[NId],
+            ChildNodes.data() + ChildBegin[NId + 1]};
+  }
+
+  std::span<const PointTy> getPoints(EdgeIdTy EId) const {
+    return {Points.data() + PointBegin[EId], Points.data() + PointEnd[EId]};
+  }
+
+  // Takes new points of an edge of the graph, the only change a snapshot
+  // follows. Points that do not fit in place move to a slot twice as large
+  // at the end, and once most of the array is left behind it is repacked.
+  void updatePoints(EdgeIdTy EId);
+
+  std::span<const NodeIdTy> getPostOrder() const { return PostOrder; }
+
+  // Position of NId in getPostOrder().
+  unsigned getPostIndex(NodeIdTy NId) const { return PostIndex[NId]; }
+
+  // Post-order of the subtree of NId, NId itself is the last node.
+  std::span<const NodeIdTy> getPostOrder(NodeIdTy NId) const {
+    auto End = PostOrder.data() + PostIndex[NId] + 1;
+    return {End - SubtreeSize[NId], End};
+  }
+};
+
+inline FrozenRCGraph freeze(const RCGraphTy &G) { return FrozenRCGraph{G}; }
+
+} // namespace algo
@@ -66,6 +66,9 @@ public:
     return impl()->getChildren(NId);
   }
 
+  // Every valid node id is less than the bound.
+  NodeIdTy getNodeIdBound() const { return impl()->getNodeIdBound(); }
+
   void setRoot(NodeIdTy NId) { impl()->setRoot(NId); }
 
   NodeIdTy getRoot() const { return impl()->getRoot(); }
@@ -239,6 +242,8 @@ public:
     return getNodeEntry(NId).getChildren();
   }
 
+  NodeIdTy getNodeIdBound() const { return Nodes.size(); }
+
   void setRoot(NodeIdTy NId) { Root = NId; }
 
   NodeIdTy getRoot() const { return Root; }
@@ -60,6 +60,18 @@ RCGraphTy readRCGraph(std::istream &IS);
 
 void dumpDot(const RCGraphTy &G, std::ostream &OS);
 
-void writeRCGraph(const RCGraphTy &G, std::ostream &OS);
+// Indented by Indent spaces per level, or compact on a single line if
+// Indent is 0.
+void writeRCGraph(const RCGraphTy &G, std::ostream &OS, unsigned Indent = 4);
+
+bool isRCGraphBinary(const std::string &Path);
+
+// Maps a net written by writeRCGraphBinary.
+RCGraphTy readRCGraphBinary(const std::string &Path);
+
+void writeRCGraphBinary(const RCGraphTy &G, std::ostream &OS);
+
+// Reads a net in either format.
+RCGraphTy loadRCGraph(const std::string &Path);
 
 } // namespace algo
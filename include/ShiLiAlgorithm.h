@@ -0,0 +1,16 @@
+#pragma once
+
+#include "BufferAlgorithm.h"
+#include "RCGraph.h"
+
+namespace algo {
+
+// Same problem as bufferInsertion, solved in the style of Shi and Li: every
+// frontier lives in a balanced search tree, wire segments are applied as
+// lazy tags at its root and the entry to drive a buffer is found on the
+// convex hull of the frontier in logarithmic time.
+SolutionTy shiLiBufferInsertion(const RCGraphTy &G,
+                                const CandidatePolicyTy &Candidates = {},
+                                EngineStatsTy *Stats = nullptr);
+
+} // namespace algo
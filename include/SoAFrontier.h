@@ -0,0 +1,136 @@
+#pragma once
+
+#include "CandidateDAG.h"
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+namespace algo {
+
+// Frontier stored as parallel arrays, so the timing pairs of all entries can
+// be updated by vector instructions while backpointers stay out of the way.
+// Invariants are those of FrontierTy: sorted by capacity and, once pruned,
+// strictly increasing in both capacity and RAT.
+template <typename FloatT> struct BasicSoAFrontier {
+  using FloatTy = FloatT;
+  using EntryTy = BasicFrontierEntryTy<FloatT>;
+
+  std::vector<FloatTy> Capacity;
+  std::vector<FloatTy> RAT;
+  std::vector<const CandidateRecordTy *> Records;
+
+  size_t size() const { return Capacity.size(); }
+  bool empty() const { return Capacity.empty(); }
+
+  size_t bytes() const {
+    return (Capacity.capacity() + RAT.capacity()) * sizeof(FloatTy) +
+           Records.capacity() * sizeof(const CandidateRecordTy *);
+  }
+
+  EntryTy operator[](size_t Idx) const {
+    return {Capacity[Idx], RAT[Idx], Records[Idx]};
+  }
+
+  void reserve(size_t Size) {
+    Capacity.reserve(Size);
+    RAT.reserve(Size);
+    Records.reserve(Size);
+  }
+
+  void clear() {
+    Capacity.clear();
+    RAT.clear();
+    Records.clear();
+  }
+
+  void resize(size_t Size) {
+    Capacity.resize(Size);
+    RAT.resize(Size);
+    Records.resize(Size);
+  }
+
+  void push_back(const EntryTy &Entry) {
+    Capacity.push_back(Entry.Capacity);
+    RAT.push_back(Entry.RAT);
+    Records.push_back(Entry.Record);
+  }
+
+  void pop_back() {
+    Capacity.pop_back();
+    RAT.pop_back();
+    Records.pop_back();
+  }
+
+  bool isSorted() const {
+    return std::is_sorted(Capacity.begin(), Capacity.end());
+  }
+};
+
+using SoAFrontierTy = BasicSoAFrontier<NodeTy::FloatTy>;
+
+// Instruction set used by the frontier kernels. The best one supported by
+// the CPU is picked at startup.
+enum class SIMDLevelTy {
+  Scalar,
+  SSE,
+  AVX2,
+};
+
+SIMDLevelTy getSIMDLevel();
+SIMDLevelTy getSupportedSIMDLevel();
+// Throws if the CPU does not support Level.
+void setSIMDLevel(SIMDLevelTy Level);
+SIMDLevelTy parseSIMDLevel(std::string_view Name);
+std::string_view getSIMDLevelName(SIMDLevelTy Level);
+
+// Kernels below are instantiated for float, double and FixedNumeric
+// frontiers. Fixed-point kernels throw std::overflow_error on overflow.
+
+// Wire segment applied to every entry:
+//   RAT -= ConstDelay + DelayPerC * C; C += AddC.
+// Kernels compute in the same order as the scalar code and never contract
+// into FMA, so results do not depend on the SIMD level.
+template <typename FloatT>
+void addWire(BasicSoAFrontier<FloatT> &Frontier, FloatT ConstDelay,
+             FloatT DelayPerC, FloatT AddC);
+
+// Drops dominated entries of a frontier sorted by capacity. Of equal entries
+// the first one survives.
+template <typename FloatT>
+void pruneDominated(BasicSoAFrontier<FloatT> &Frontier);
+
+// Most that a pass of pruneApproximate gave up for a dropped entry. An entry
+// is covered either by one with less capacity and less RAT, or by one with
+// more capacity and more RAT, so it loses RAT or capacity, never both.
+template <typename FloatT> struct ApproximationLossTy {
+  FloatT RAT{};
+  FloatT Capacity{};
+};
+
+// Drops entries of a pruned frontier that a kept entry nearly dominates:
+// has at most CapacityBucket more capacity and at most RATTolerance less
+// RAT. Every dropped entry is covered by a kept one directly, so a pass
+// costs at most RATTolerance plus the delay of CapacityBucket upstream, and
+// usually much less: the returned loss is what this pass actually gave up.
+template <typename FloatT>
+ApproximationLossTy<FloatT> pruneApproximate(BasicSoAFrontier<FloatT> &Frontier,
+                                             FloatT RATTolerance,
+                                             FloatT CapacityBucket);
+
+template <typename FloatT>
+void buildHull(const BasicSoAFrontier<FloatT> &Frontier, HullTy &Hull);
+
+// Merges entries sorted by capacity into a frontier sorted by capacity, Lhs
+// entries go first on equal capacity. The result is not pruned.
+template <typename FloatT>
+void mergeSorted(const BasicSoAFrontier<FloatT> &Lhs,
+                 const BasicFrontierTy<FloatT> &Rhs,
+                 BasicSoAFrontier<FloatT> &Merged);
+
+template <typename FloatT>
+BasicSoAFrontier<FloatT> mergeFrontiers(const BasicSoAFrontier<FloatT> &Lhs,
+                                        const BasicSoAFrontier<FloatT> &Rhs,
+                                        CandidateDAG &DAG);
+
+} // namespace algo
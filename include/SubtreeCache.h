@@ -0,0 +1,93 @@
+#pragma once
+
+#include "BufferAlgorithm.h"
+#include "CandidateDAG.h"
+#include "Config.h"
+
+#include <any>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <shared_mutex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace algo {
+
+struct SubtreeCacheStatsTy {
+  // Distinct subtrees seen so far.
+  size_t Subtrees = 0;
+  // Subtrees whose frontier is kept.
+  size_t Frontiers = 0;
+  // Subtrees whose frontier was reused instead of being solved.
+  size_t Hits = 0;
+  size_t Bytes = 0;
+};
+
+// Frontiers of subtrees, shared by the runs of many nets on many threads.
+// A subtree is identified by its shape relative to its root: the points of
+// its parent edge and of every edge below, sink loads and sink RATs relative
+// to the smallest one. Its frontier is kept in the same relative form and
+// shifted by the RAT offset of every subtree that reuses it.
+//
+// The cache binds to the arithmetic, delay model, technology, candidate
+// policy and approximation of its first run, runs with other settings throw.
+// Nothing is ever evicted: once the cache holds its budget of bytes, new
+// subtrees are no longer admitted.
+class SubtreeCache final {
+public:
+  using IdTy = unsigned;
+  // Canonical description of a subtree, its children are given by their ids.
+  using KeyTy = std::vector<std::uint64_t>;
+
+  static constexpr size_t DefaultBudget = size_t{256} << 20;
+
+  static constexpr IdTy invalidId() { return std::numeric_limits<IdTy>::max(); }
+
+  explicit SubtreeCache(size_t BudgetBytes = DefaultBudget)
+      : Budget{BudgetBytes} {}
+
+  SubtreeCache(const SubtreeCache &) = delete;
+  SubtreeCache &operator=(const SubtreeCache &) = delete;
+
+  SubtreeCacheStatsTy getStats() const;
+
+private:
+  template <typename NetT> friend class SubtreeReuse;
+
+  struct KeyHashTy {
+    size_t operator()(const KeyTy &Key) const;
+  };
+
+  mutable std::shared_mutex Mutex;
+  size_t Budget;
+  size_t Bytes = 0;
+  std::atomic<size_t> Hits = 0;
+
+  // Settings of the first run.
+  const std::type_info *Engine = nullptr;
+  Technology Tech;
+  std::vector<Module> Library;
+  CandidatePolicyTy Candidates;
+  ApproximationTy Approximation;
+
+  std::unordered_map<KeyTy, IdTy, KeyHashTy> Ids;
+  // Records of kept frontiers, with positions relative to the subtree root,
+  // edges given by the post-order index of their last node within the
+  // subtree, RATs relative to its offset and buffers taken from Library.
+  CandidateDAG Records;
+  // Frontiers indexed by id, in the arithmetic of the bound engine. Empty
+  // ones are not kept.
+  std::any Frontiers;
+  size_t NumFrontiers = 0;
+
+  // Binds the cache on the first call, throws if any setting differs from
+  // the bound ones. The caller holds the exclusive lock.
+  void bind(const std::type_info &EngineTy, const Config &Cfg,
+            const CandidatePolicyTy &Policy, const ApproximationTy &Approx);
+
+  bool isFull() const { return Bytes >= Budget; }
+};
+
+} // namespace algo
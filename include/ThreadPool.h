@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace algo {
+
+// Fixed-size work-stealing thread pool. Every worker owns a deque: tasks
+// submitted from a worker go to the back of its own deque and are taken
+// from there again, idle workers steal from the front of other deques.
+class ThreadPool final {
+public:
+  using TaskTy = std::function<void()>;
+
+  explicit ThreadPool(unsigned Threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  unsigned size() const { return Workers.size(); }
+
+  // Index of the calling worker of this pool, size() for other threads.
+  unsigned currentWorker() const;
+
+  void submit(TaskTy Task);
+
+  // Blocks until every submitted task, including the ones submitted by
+  // other tasks, has finished. Rethrows the first exception of a task.
+  void wait();
+
+private:
+  struct QueueTy {
+    std::mutex Lock;
+    std::deque<TaskTy> Tasks;
+  };
+
+  std::vector<std::unique_ptr<QueueTy>> Queues;
+  std::vector<std::thread> Workers;
+
+  std::mutex SleepLock;
+  std::condition_variable WakeUp;
+  std::condition_variable Finished;
+  size_t Queued = 0;
+  size_t Unfinished = 0;
+  bool Stop = false;
+  std::exception_ptr Error;
+
+  std::atomic<unsigned> NextQueue = 0;
+
+  bool tryPop(unsigned Worker, TaskTy &Task);
+  void run(unsigned Worker);
+};
+
+} // namespace algo
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "Config.h"
+#include "RCGraph.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace algo {
+
+// Arithmetic of the dynamic programming. Graph and technology values are read
+// as NodeTy::FloatTy and converted once, reported values are converted back.
+// Delay models derive their coefficients in RealTy before converting them.
+template <typename FloatT> struct FloatingNumeric {
+  using ValueTy = FloatT;
+  using RealTy = FloatT;
+
+  static ValueTy fromReal(RealTy Value) { return Value; }
+
+  static ValueTy fromFloat(NodeTy::FloatTy Value) {
+    return static_cast<ValueTy>(Value);
+  }
+
+  static NodeTy::FloatTy toFloat(ValueTy Value) {
+    return static_cast<NodeTy::FloatTy>(Value);
+  }
+
+  static ValueTy add(ValueTy Lhs, ValueTy Rhs) { return Lhs + Rhs; }
+
+  static ValueTy sub(ValueTy Lhs, ValueTy Rhs) { return Lhs - Rhs; }
+
+  // Const + PerUnit * X.
+  static ValueTy linear(ValueTy Const, ValueTy PerUnit, ValueTy X) {
+    return Const + PerUnit * X;
+  }
+};
+
+using SingleNumeric = FloatingNumeric<float>;
+using DoubleNumeric = FloatingNumeric<double>;
+
+// Scaled integers, Value stands for Value / 2^FracBits. Sums are exact and
+// products are rounded half up, so results do not depend on the order of
+// evaluation and are the same for every thread count and SIMD level. Every
+// operation throws std::overflow_error rather than wrap around.
+struct FixedNumeric {
+  using ValueTy = std::int32_t;
+  using RealTy = double;
+
+  static constexpr unsigned FracBits = 16;
+  static constexpr RealTy Scale = RealTy(1 << FracBits);
+
+  static ValueTy narrow(std::int64_t Value) {
+    if (Value < std::numeric_limits<ValueTy>::min() ||
+        Value > std::numeric_limits<ValueTy>::max())
+      throw std::overflow_error("fixed-point timing value out of range");
+    return static_cast<ValueTy>(Value);
+  }
+
+  static ValueTy fromReal(RealTy Value) {
+    auto Scaled = std::round(Value * Scale);
+    if (!(Scaled >= std::numeric_limits<ValueTy>::min() &&
+          Scaled <= std::numeric_limits<ValueTy>::max()))
+      throw std::overflow_error("fixed-point timing value out of range");
+    return static_cast<ValueTy>(Scaled);
+  }
+
+  static ValueTy fromFloat(NodeTy::FloatTy Value) { return fromReal(Value); }
+
+  static NodeTy::FloatTy toFloat(ValueTy Value) {
+    return static_cast<NodeTy::FloatTy>(Value / Scale);
+  }
+
+  static ValueTy add(ValueTy Lhs, ValueTy Rhs) {
+    return narrow(std::int64_t{Lhs} + Rhs);
+  }
+
+  static ValueTy sub(ValueTy Lhs, ValueTy Rhs) {
+    return narrow(std::int64_t{Lhs} - Rhs);
+  }
+
+  // Product before narrowing.
+  static std::int64_t mulWide(ValueTy Lhs, ValueTy Rhs) {
+    return (std::int64_t{Lhs} * Rhs + (std::int64_t{1} << (FracBits - 1))) >>
+           FracBits;
+  }
+
+  static ValueTy linear(ValueTy Const, ValueTy PerUnit, ValueTy X) {
+    return narrow(Const + mulWide(PerUnit, X));
+  }
+};
+
+// Numeric policy of a frontier value type, for kernels that only see values.
+template <typename ValueT> struct NumericOf;
+
+template <> struct NumericOf<float> {
+  using Ty = SingleNumeric;
+};
+
+template <> struct NumericOf<double> {
+  using Ty = DoubleNumeric;
+};
+
+template <> struct NumericOf<FixedNumeric::ValueTy> {
+  using Ty = FixedNumeric;
+};
+
+// Wire segment applied to every frontier entry:
+//   RAT -= ConstDelay + DelayPerC * C; C += AddC.
+template <typename ValueT> struct WireSegmentTy {
+  ValueT ConstDelay;
+  ValueT DelayPerC;
+  ValueT AddC;
+};
+
+// Per unit length wire constants of a technology.
+template <typename RealT> struct WireConstantsTy {
+  RealT R;
+  RealT C;
+  RealT RC;
+};
+
+// Timing view of a buffer in the arithmetic of the engine. Cell is what
+// candidate records point to.
+template <typename ValueT> struct BufferTimingTy {
+  ValueT K;
+  ValueT R;
+  ValueT C;
+  const Module *Cell;
+};
+
+// Delay models give the wire segment of a given length and the delay of a
+// buffer driving a load. Both must be linear in the downstream capacity, the
+// frontier kernels and the hull search rely on it.
+
+// Distributed RC line: r * c * L^2 / 2 + r * L * C.
+struct ElmoreDelay {
+  template <typename NumericT>
+  static WireSegmentTy<typename NumericT::ValueTy>
+  wire(const WireConstantsTy<typename NumericT::RealTy> &Wire,
+       unsigned Length) {
+    using RealTy = typename NumericT::RealTy;
+    return {NumericT::fromReal(
+                (Wire.RC * static_cast<RealTy>(Length * Length)) / 2),
+            NumericT::fromReal(Wire.R * static_cast<RealTy>(Length)),
+            NumericT::fromReal(Wire.C * static_cast<RealTy>(Length))};
+  }
+
+  template <typename NumericT>
+  static typename NumericT::ValueTy
+  buffer(const BufferTimingTy<typename NumericT::ValueTy> &Buffer,
+         typename NumericT::ValueTy Load) {
+    return NumericT::linear(Buffer.K, Buffer.R, Load);
+  }
+};
+
+// Lumped RC: the whole wire resistance drives the whole wire capacitance,
+// r * L * (c * L + C). Pessimistic by r * c * L^2 / 2 against Elmore.
+struct LumpedDelay {
+  template <typename NumericT>
+  static WireSegmentTy<typename NumericT::ValueTy>
+  wire(const WireConstantsTy<typename NumericT::RealTy> &Wire,
+       unsigned Length) {
+    using RealTy = typename NumericT::RealTy;
+    return {NumericT::fromReal(
+                Wire.RC * static_cast<RealTy>(Length * Length)),
+            NumericT::fromReal(Wire.R * static_cast<RealTy>(Length)),
+            NumericT::fromReal(Wire.C * static_cast<RealTy>(Length))};
+  }
+
+  template <typename NumericT>
+  static typename NumericT::ValueTy
+  buffer(const BufferTimingTy<typename NumericT::ValueTy> &Buffer,
+         typename NumericT::ValueTy Load) {
+    return ElmoreDelay::buffer<NumericT>(Buffer, Load);
+  }
+};
+
+// Everything the engine needs from a Config, converted to its arithmetic
+// once per run, so the inner loop touches no strings, maps or heap memory.
+// The context is trivially copyable, buffers live in a library that the
+// caller keeps alive.
+template <typename NumericT, typename DelayModelT> class TimingContextTy {
+public:
+  using NumericTy = NumericT;
+  using ValueTy = typename NumericT::ValueTy;
+  using RealTy = typename NumericT::RealTy;
+  using BufferTy = BufferTimingTy<ValueTy>;
+  using LibraryTy = std::vector<BufferTy>;
+
+private:
+  WireConstantsTy<RealTy> Wire;
+  std::span<const BufferTy> Buffers;
+  BufferTy Driver;
+
+public:
+  // Fills Library with the buffers of Cfg and takes the one named Driver as
+  // the driver of the net.
+  TimingContextTy(const Config &Cfg, std::string_view DriverName,
+                  LibraryTy &Library) {
+    const auto &Tech = Cfg.getTechnology();
+    Wire.R = Tech.UnitR;
+    Wire.C = Tech.UnitC;
+    Wire.RC = Wire.R * Wire.C;
+
+    Library.clear();
+    for (const auto &M : Cfg.getModules(ModuleKind::Buffer))
+      Library.push_back(compile(M));
+    Buffers = Library;
+    Driver = compile(Cfg.getModule(ModuleKind::Buffer, DriverName));
+  }
+
+  static BufferTy compile(const Module &M) {
+    return {NumericT::fromFloat(M.K), NumericT::fromFloat(M.R),
+            NumericT::fromFloat(M.C), &M};
+  }
+
+  std::span<const BufferTy> getBuffers() const { return Buffers; }
+
+  const BufferTy &getDriver() const { return Driver; }
+
+  WireSegmentTy<ValueTy> wire(unsigned Length) const {
+    return DelayModelT::template wire<NumericT>(Wire, Length);
+  }
+
+  ValueTy bufferedRAT(const BufferTy &Buffer, ValueTy RAT,
+                      ValueTy Load) const {
+    return NumericT::sub(RAT,
+                         DelayModelT::template buffer<NumericT>(Buffer, Load));
+  }
+};
+
+} // namespace algo
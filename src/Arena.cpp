@@ -0,0 +1,79 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace algo {
+
+namespace {
+
+std::atomic<bool> UseHugePages = false;
+
+constexpr size_t HugePageSize = size_t{2} << 20;
+
+} // namespace
+
+void Arena::setUseHugePages(bool Use) { UseHugePages = Use; }
+
+Arena::~Arena() {
+  for (auto &&Block : Blocks) {
+    if (Block.HugePages)
+      std::free(Block.Data);
+    else
+      ::operator delete(Block.Data);
+  }
+}
+
+void *Arena::allocateSlow(size_t Size, size_t Align) {
+  // Blocks kept from before a reset are reused first, a block that is too
+  // small for this request is skipped.
+  while (Current + 1 < Blocks.size()) {
+    const auto &Block = Blocks[++Current];
+    Ptr = Block.Data;
+    End = Block.Data + Block.Size;
+    if (Size + Align <= Block.Size)
+      return allocate(Size, Align);
+  }
+
+  auto NewSize = std::max(BlockSize, Size + Align);
+  BlockTy Block{nullptr, NewSize, false};
+#if defined(__linux__)
+  if (UseHugePages) {
+    Block.Size = (NewSize + HugePageSize - 1) / HugePageSize * HugePageSize;
+    Block.Data = static_cast<std::byte *>(
+        std::aligned_alloc(HugePageSize, Block.Size));
+    if (Block.Data) {
+      Block.HugePages = true;
+      ::madvise(Block.Data, Block.Size, MADV_HUGEPAGE);
+    }
+  }
+#endif
+  if (!Block.Data) {
+    Block.Size = NewSize;
+    Block.Data = static_cast<std::byte *>(::operator new(NewSize));
+  }
+
+  Blocks.push_back(Block);
+  Current = Blocks.size() - 1;
+  Ptr = Block.Data;
+  End = Block.Data + Block.Size;
+  ++Stats.Blocks;
+  Stats.BytesReserved += Block.Size;
+  return allocate(Size, Align);
+}
+
+void Arena::reset() {
+  Current = 0;
+  Ptr = Blocks.empty() ? nullptr : Blocks.front().Data;
+  End = Blocks.empty() ? nullptr : Blocks.front().Data + Blocks.front().Size;
+  Stats.Allocations = 0;
+  Stats.BytesUsed = 0;
+  ++Stats.Resets;
+}
+
+} // namespace algo
@@ -1,34 +1,53 @@
 #include "BufferAlgorithm.h"
+#include "CandidateDAG.h"
+#include "FrozenRCGraph.h"
+#include "SoAFrontier.h"
+#include "SubtreeCache.h"
+#include "ThreadPool.h"
 
-#include <unordered_set>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
 
 using namespace algo;
 
 #if DEBUG
 
 #define LOG(...) fprintf(stderr, __VA_ARGS__)
-#define LOG_NODE(node, solutions)                                              \
+#define LOG_NODE(node, solutions, NumericT)                                    \
   do {                                                                         \
-    auto best_solution =                                                       \
-        std::max_element(solutions.begin(), solutions.end(),                   \
-                         [](const auto &lhs, const auto &rhs) {                \
-                           return lhs.back().RAT < rhs.back().RAT;             \
-                         });                                                   \
+    auto best_idx = std::distance(                                             \
+        solutions.RAT.begin(),                                                 \
+        std::max_element(solutions.RAT.begin(), solutions.RAT.end()));         \
     LOG("[DEBUG] Visiting Node %s (%d, %d):\n\tOptimal RAT = %lf\n\tCapacity " \
         "= %lf\n\n",                                                           \
-        node.Name.c_str(), node.P.X, node.P.Y, best_solution->back().RAT,      \
-        best_solution->back().Capacity);                                       \
+        node.Name.c_str(), node.P.X, node.P.Y,                                 \
+        NumericT::toFloat(solutions.RAT[best_idx]),                            \
+        NumericT::toFloat(solutions.Capacity[best_idx]));                      \
   } while (false)
 
 #else
 
 #define LOG(...)
-#define LOG_NODE(nodeid, solutions)
+#define LOG_NODE(nodeid, solutions, NumericT)
 
 #endif
 
-static PointsTy splitEdge(const EdgeTy &edge, unsigned step) {
-  const auto &points = edge.Ps;
+namespace algo {
+
+PointsTy splitEdge(const EdgeTy &edge, unsigned step) {
+  return splitEdge(edge.Ps, step);
+}
+
+PointsTy splitEdge(std::span<const PointTy> points, unsigned step) {
   PointsTy candidates;
 
   auto lhs_it = points.rbegin();
@@ -54,231 +73,1613 @@ static PointsTy splitEdge(const EdgeTy &edge, unsigned step) {
   return candidates;
 }
 
-static void insert(SolutionTy &solution, unsigned length, PointTy position,
-                   EdgeTy::EdgeIdTy eid, const RCGraphTy &G) {
-  auto &last_candidate = solution.back();
-  auto rat = last_candidate.RAT;
-  auto capacity = last_candidate.Capacity;
+} // namespace algo
 
-  Technology wire = G.getAttrs().getTechnology();
+static unsigned edgeLength(std::span<const PointTy> points) {
+  unsigned length = 0;
+  for (size_t idx = 1; idx < points.size(); ++idx)
+    length += points[idx - 1].distance(points[idx]);
+  return length;
+}
+
+static unsigned relativeStep(std::span<const PointTy> points,
+                             double fraction) {
+  auto step = std::lround(fraction * edgeLength(points));
+  return step < 1 ? 1 : static_cast<unsigned>(step);
+}
 
-  NodeTy::FloatTy wire_delay =
-      (wire.UnitR * wire.UnitC * (length * length)) / 2 +
-      wire.UnitR * length * capacity;
-  NodeTy::FloatTy new_rat = rat - wire_delay;
-  NodeTy::FloatTy new_capacity = capacity + wire.UnitC * length;
+// Points at the given distances from the last node of the edge, followed by
+// its first node. Distances must be increasing and below the edge length.
+static PointsTy pointsAt(std::span<const PointTy> points,
+                         std::span<const unsigned> distances) {
+  PointsTy candidates;
+  candidates.reserve(distances.size() + 1);
 
-  //  LOG("WIRE Insertion:\n\tRAT: %lf -> %lf\n\tCapacity: %lf -> %lf\n\n", rat,
-  //  new_rat, capacity, new_capacity);
+  auto distance = distances.begin();
+  unsigned start = 0;
+  for (auto lhs_it = points.rbegin(), rhs_it = std::next(points.rbegin());
+       rhs_it != points.rend(); ++lhs_it, ++rhs_it) {
+    unsigned end = start + lhs_it->distance(*rhs_it);
+    int dx = (rhs_it->X > lhs_it->X) - (rhs_it->X < lhs_it->X);
+    int dy = (rhs_it->Y > lhs_it->Y) - (rhs_it->Y < lhs_it->Y);
+    for (; distance != distances.end() && *distance <= end; ++distance) {
+      int offset = *distance - start;
+      candidates.emplace_back(lhs_it->X + dx * offset, lhs_it->Y + dy * offset);
+    }
+    start = end;
+  }
 
-  solution.emplace_back(new_capacity, new_rat, position, eid,
-                        /*HasBuffer=*/false);
+  candidates.push_back(points.front());
+  return candidates;
 }
 
-void insert(SolutionTy &solution, const RCGraphTy &G) {
-  auto &last_candidate = solution.back();
+// Distances that split [start, start + length] into parts equal parts,
+// rounded. Ones that round onto an end of the range or onto the previous
+// distance are dropped.
+static void splitEvenly(unsigned start, unsigned length, unsigned parts,
+                        std::vector<unsigned> &distances) {
+  for (unsigned part = 1; part < parts; ++part) {
+    auto distance =
+        start + static_cast<unsigned>((std::uint64_t{length} * part + parts / 2) /
+                                      parts);
+    if (distance > start && distance < start + length &&
+        (distances.empty() || distances.back() < distance))
+      distances.push_back(distance);
+  }
+}
 
-  Module buffer = G.getAttrs().getModule(ModuleKind::Buffer);
+namespace algo {
 
-  NodeTy::FloatTy buffer_delay = buffer.K + buffer.R * last_candidate.Capacity;
-  last_candidate.RAT -= buffer_delay;
-  last_candidate.Capacity = buffer.C;
-  last_candidate.HasBuffer = true;
+PointsTy splitEdge(std::span<const PointTy> points,
+                   const CandidatePolicyTy &policy) {
+  using KindTy = CandidatePolicyTy::KindTy;
 
-  //  LOG("BUFFER Insertion:\n\tRAT: %lf -> %lf\n\tCapacity: %lf -> %lf\n\n",
-  //  rat, last_candidate.RAT, capacity, last_candidate.Capacity);
+  std::vector<unsigned> distances;
+  switch (policy.Kind) {
+  case KindTy::Step:
+    return splitEdge(points, policy.Step);
+  case KindTy::Relative:
+    return splitEdge(points, relativeStep(points, policy.Fraction));
+  case KindTy::MaxPerEdge:
+    splitEvenly(0, edgeLength(points), policy.Count, distances);
+    break;
+  case KindTy::Bends: {
+    unsigned start = 0;
+    for (auto lhs_it = points.rbegin(), rhs_it = std::next(points.rbegin());
+         rhs_it != points.rend(); ++lhs_it, ++rhs_it) {
+      unsigned length = lhs_it->distance(*rhs_it);
+      splitEvenly(start, length, policy.Count + 1, distances);
+      start += length;
+      // The bend, unless it is the first node of the edge.
+      if (std::next(rhs_it) != points.rend() &&
+          (distances.empty() || distances.back() < start))
+        distances.push_back(start);
+    }
+    break;
+  }
+  }
+  return pointsAt(points, distances);
 }
 
-static std::vector<SolutionTy>
-redundancy_elimination(std::vector<SolutionTy> &&solutions) {
-  auto isRedundant = [](const SolutionTy &validator,
-                        const SolutionTy &solution) {
-    auto validator_candidate = validator.back();
-    auto solution_candidate = solution.back();
-    return validator_candidate.RAT >= solution_candidate.RAT &&
-           validator_candidate.Capacity <= solution_candidate.Capacity;
+} // namespace algo
+
+template <typename TimingT>
+static void insert(const TimingT &timing,
+                   BasicFrontierEntryTy<typename TimingT::ValueTy> &entry,
+                   const typename TimingT::BufferTy &buffer) {
+  entry.RAT = timing.bufferedRAT(buffer, entry.RAT, entry.Capacity);
+  entry.Capacity = buffer.C;
+}
+
+template <typename TimingT>
+static void insert(const TimingT &timing,
+                   BasicFrontierEntryTy<typename TimingT::ValueTy> &entry,
+                   PointTy position, EdgeTy::EdgeIdTy eid,
+                   const typename TimingT::BufferTy &buffer,
+                   CandidateDAG &dag) {
+  using NumericT = typename TimingT::NumericTy;
+
+  insert(timing, entry, buffer);
+  entry.Record = dag.addBuffer(entry.Record, NumericT::toFloat(entry.Capacity),
+                               NumericT::toFloat(entry.RAT), position, eid,
+                               *buffer.Cell);
+}
+
+// Hull vertices are ordered by capacity and RAT - R * C is concave along
+// them, so the best vertex to drive the buffer is found by binary search for
+// the first one that its successor does not improve.
+template <typename TimingT>
+static size_t
+findBestDriven(const TimingT &timing,
+               const BasicSoAFrontier<typename TimingT::ValueTy> &solutions,
+               const HullTy &hull, const typename TimingT::BufferTy &buffer) {
+  assert(!hull.empty());
+  auto buffered_rat = [&](size_t idx) {
+    return timing.bufferedRAT(buffer, solutions.RAT[idx],
+                              solutions.Capacity[idx]);
   };
+  size_t lhs = 0;
+  size_t rhs = hull.size() - 1;
+  while (lhs != rhs) {
+    auto mid = lhs + (rhs - lhs) / 2;
+    if (buffered_rat(hull[mid + 1]) > buffered_rat(hull[mid]))
+      lhs = mid + 1;
+    else
+      rhs = mid;
+  }
+  return hull[lhs];
+}
 
-  unsigned id = 0;
-  std::vector<std::pair<unsigned, SolutionTy>> identified_solutions;
-  std::transform(
-      solutions.begin(), solutions.end(),
-      std::back_inserter(identified_solutions),
-      [&id](const auto &solution) -> std::pair<unsigned, SolutionTy> {
-        return {id++, solution};
-      });
+namespace {
 
-  std::unordered_set<unsigned> redundant_solutions;
-  for (auto lhs_it = identified_solutions.begin();
-       lhs_it != std::prev(identified_solutions.end()); ++lhs_it) {
-    for (auto rhs_it = std::next(lhs_it); rhs_it != identified_solutions.end();
-         ++rhs_it) {
-      if (isRedundant(lhs_it->second, rhs_it->second))
-        redundant_solutions.insert(rhs_it->first);
-      else if (isRedundant(rhs_it->second, lhs_it->second))
-        redundant_solutions.insert(lhs_it->first);
-    }
+// What approximate pruning may have given up below a node. Take an entry
+// of the exact frontier and the entry that stands for it in the kept one:
+// the kept entry has at most ExtraCapacity more capacity, and the RAT it
+// lost plus the delay of its extra capacity through the weakest buffer is
+// at most Loss. A buffer that drives it turns the second part into lost RAT
+// and drops the first, so the bound holds wherever the buffers are.
+struct LossBoundTy {
+  double ExtraCapacity = 0;
+  double Loss = 0;
+
+  void join(const LossBoundTy &child, double weakest) {
+    Loss = std::max(Loss + weakest * child.ExtraCapacity,
+                    child.Loss + weakest * ExtraCapacity);
+    ExtraCapacity += child.ExtraCapacity;
   }
 
-  identified_solutions.erase(
-      std::remove_if(identified_solutions.begin(), identified_solutions.end(),
-                     [&redundant_solutions](const auto &identified_solution) {
-                       return redundant_solutions.find(
-                                  identified_solution.first) !=
-                              redundant_solutions.end();
-                     }),
-      identified_solutions.end());
-
-  std::vector<SolutionTy> pruned_solutions;
-  std::transform(identified_solutions.begin(), identified_solutions.end(),
-                 std::back_inserter(pruned_solutions),
-                 [](const auto &identified_solution) {
-                   return identified_solution.second;
-                 });
-  return pruned_solutions;
-}
-
-static std::vector<SolutionTy>
-mergeTwoSolutions(const std::vector<SolutionTy> &lhs,
-                  const std::vector<SolutionTy> &rhs, PointTy position) {
-  std::vector<SolutionTy> solutions;
-  for (auto &lhs_solution : lhs) {
-    for (auto &rhs_solution : rhs) {
-      auto &lhs_candidate = lhs_solution.back();
-      auto &rhs_candidate = rhs_solution.back();
-
-      SolutionTy solution;
-      std::copy(lhs_solution.begin(), lhs_solution.end(),
-                std::back_inserter(solution));
-      std::copy(rhs_solution.begin(), rhs_solution.end(),
-                std::back_inserter(solution));
-
-      solution.emplace_back(lhs_candidate.Capacity + rhs_candidate.Capacity,
-                            std::min(lhs_candidate.RAT, rhs_candidate.RAT),
-                            position, RCGraphTy::invalidEdgeId(), false);
-      solutions.push_back(solution);
-    }
+  // A wire, then a pruning pass that lost at most rat for one entry and
+  // capacity for another.
+  void prune(double delay_per_c, double rat, double capacity,
+             double weakest) {
+    Loss += delay_per_c * ExtraCapacity + std::max(rat, weakest * capacity);
+    ExtraCapacity += capacity;
+  }
+
+  // The kept entry is in the frontier, and the least capacity of a frontier
+  // is never pruned, so it has at most the spread of the frontier more
+  // capacity than any exact entry.
+  template <typename FloatT>
+  void cap(const BasicSoAFrontier<FloatT> &frontier) {
+    using NumericT = typename NumericOf<FloatT>::Ty;
+    if (!frontier.empty())
+      ExtraCapacity = std::min<double>(
+          ExtraCapacity, NumericT::toFloat(NumericT::sub(
+                             frontier.Capacity.back(), frontier.Capacity[0])));
+  }
+};
+
+// State shared by all nodes of a net. Frontiers are indexed by node id, the
+// frontier of a node lives from the moment it is solved until its parent
+// consumes it, so only a cut of the tree is kept alive at any time. A net
+// solved incrementally keeps every frontier, as its parent may be solved
+// again.
+template <typename NumericT, typename DelayModelT> struct NetStateTy {
+  using NumericTy = NumericT;
+  using TimingTy = TimingContextTy<NumericT, DelayModelT>;
+  using ValueTy = typename NumericT::ValueTy;
+  using EntryTy = BasicFrontierEntryTy<ValueTy>;
+  using FrontierTy = BasicSoAFrontier<ValueTy>;
+
+  static_assert(std::is_trivially_copyable_v<TimingTy>);
+
+  const FrozenRCGraph &F;
+  typename TimingTy::LibraryTy Library;
+  TimingTy Timing;
+  CandidatePolicyTy Candidates;
+  ApproximationTy Approximation;
+  ValueTy RATTolerance;
+  ValueTy CapacityBucket;
+  bool KeepFrontiers;
+  std::vector<FrontierTy> Frontiers;
+  // Kept only with approximation. The driver is one of the buffers.
+  std::vector<LossBoundTy> LossBounds;
+  double WeakestR = 0;
+
+  std::atomic<size_t> LiveBytes = 0;
+  std::atomic<size_t> PeakBytes = 0;
+  std::atomic<size_t> ReusedSubtrees = 0;
+
+  NetStateTy(const FrozenRCGraph &f, const CandidatePolicyTy &candidates,
+             const ApproximationTy &approximation,
+             bool keep_frontiers = false)
+      : F{f}, Timing{f.getAttrs(), f.getNode(f.getRoot()).Name, Library},
+        Candidates{candidates}, Approximation{approximation},
+        RATTolerance{NumericT::fromReal(approximation.RATTolerance)},
+        CapacityBucket{NumericT::fromReal(approximation.CapacityBucket)},
+        KeepFrontiers{keep_frontiers}, Frontiers(f.getNodeIdBound()) {
+    if (approximation.isExact())
+      return;
+    LossBounds.resize(f.getNodeIdBound());
+    for (const auto &buffer : f.getAttrs().getModules(ModuleKind::Buffer))
+      WeakestR = std::max<double>(WeakestR, buffer.R);
+  }
+
+  void store(NodeTy::NodeIdTy node, FrontierTy &&frontier) {
+    if (auto replaced = Frontiers[node].bytes())
+      LiveBytes.fetch_sub(replaced, std::memory_order_relaxed);
+    auto size = frontier.bytes();
+    auto live = LiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    auto peak = PeakBytes.load(std::memory_order_relaxed);
+    while (peak < live &&
+           !PeakBytes.compare_exchange_weak(peak, live,
+                                            std::memory_order_relaxed))
+      ;
+    Frontiers[node] = std::move(frontier);
+  }
+
+  FrontierTy take(NodeTy::NodeIdTy node) {
+    if (KeepFrontiers)
+      return Frontiers[node];
+    FrontierTy frontier = std::move(Frontiers[node]);
+    LiveBytes.fetch_sub(frontier.bytes(), std::memory_order_relaxed);
+    return frontier;
+  }
+};
+
+// Buffers of a worker reused from one edge segment to the next.
+template <typename NetT> struct ScratchTy {
+  HullTy Hull;
+  std::vector<typename NetT::EntryTy> Buffered;
+  typename NetT::FrontierTy Merged;
+  // Used by trade-off runs only.
+  typename NetT::FrontierTy Fewer;
+  std::vector<CandidateRecordTy> Staged;
+};
+
+} // namespace
+
+// Children frontiers are moved out of the net state and merged in the order
+// of the children.
+template <typename NetT>
+static typename NetT::FrontierTy
+mergeSolutions(NetT &net, NodeTy::NodeIdTy top, CandidateDAG &dag) {
+  using NumericT = typename NetT::NumericTy;
+
+  const auto &node = net.F.getNode(top);
+  auto children = net.F.getChildNodes(top);
+  if (node.Kind == NodeKindTy::Point) {
+    assert(children.empty());
+    typename NetT::FrontierTy leaf;
+    leaf.push_back({NumericT::fromFloat(node.Capacity),
+                    NumericT::fromFloat(node.RAT), nullptr});
+    return leaf;
+  }
+
+  assert(!children.empty());
+  assert(std::all_of(children.begin(), children.end(), [&](auto child) {
+    return !net.Frontiers[child].empty();
+  }));
+
+  auto solutions = net.take(children.front());
+  for (auto child : children.subspan(1)) {
+    auto child_solutions = net.take(child);
+    solutions = mergeFrontiers(solutions, child_solutions, dag);
   }
   return solutions;
 }
 
-static std::vector<SolutionTy>
-mergeSolutions(const std::vector<std::vector<SolutionTy>> &children_solutions,
-               const NodeTy &node) {
-  if (node.Kind == NodeKindTy::Point) {
-    assert(children_solutions.empty());
-    return std::vector<SolutionTy>{SolutionTy{
-        {node.Capacity, node.RAT, node.P, RCGraphTy::invalidEdgeId(), false}}};
+// Merges the frontiers of the children of top and, unless top is the root,
+// buffers them along its parent edge. All children must be solved.
+template <typename NetT>
+static void solveNode(NetT &net, NodeTy::NodeIdTy top, CandidateDAG &dag,
+                      ScratchTy<NetT> &scratch) {
+  const auto &F = net.F;
+  // Copied, so the compiler knows that frontier updates cannot change it.
+  const auto timing = net.Timing;
+
+  auto solutions = mergeSolutions(net, top, dag);
+
+  LOG_NODE(F.getNode(top), solutions, NetT::NumericTy);
+
+  LossBoundTy bound;
+  bool approximate = !net.Approximation.isExact();
+  if (approximate) {
+    for (auto child : F.getChildNodes(top))
+      bound.join(net.LossBounds[child], net.WeakestR);
+    bound.cap(solutions);
+  }
+
+  if (top == F.getRoot()) {
+    if (approximate)
+      net.LossBounds[top] = bound;
+    net.store(top, std::move(solutions));
+    return;
   }
 
-  assert(std::all_of(children_solutions.begin(), children_solutions.end(),
-                     [](const auto &solution) { return !solution.empty(); }));
+  EdgeTy::EdgeIdTy edge_id = F.getParent(top);
+  PointsTy points = splitEdge(F.getPoints(edge_id), net.Candidates);
 
-  if (children_solutions.size() == 1)
-    return children_solutions.front();
+  PointTy position = F.getNode(top).P;
+  for (auto &point : points) {
+    unsigned length = position.distance(point);
+    position = point;
+    auto wire = timing.wire(length);
+    addWire(solutions, wire.ConstDelay, wire.DelayPerC, wire.AddC);
 
-  if (children_solutions.size() == 2)
-    return mergeTwoSolutions(children_solutions.front(),
-                             children_solutions.back(), node.P);
+    pruneDominated(solutions);
+    buildHull(solutions, scratch.Hull);
 
-  std::vector<SolutionTy> solutions = *children_solutions.begin();
-  for (auto current_child = std::next(children_solutions.begin());
-       current_child != children_solutions.end(); ++current_child) {
-    solutions = mergeTwoSolutions(std::move(solutions), *current_child, node.P);
-    solutions = redundancy_elimination(std::move(solutions));
+    // Only the best entry for each buffer type can survive pruning, as
+    // all entries driven by the same buffer share its input capacity.
+    auto &buffered = scratch.Buffered;
+    buffered.clear();
+    for (auto &buffer : timing.getBuffers()) {
+      buffered.push_back(
+          solutions[findBestDriven(timing, solutions, scratch.Hull, buffer)]);
+      insert(timing, buffered.back(), point, edge_id, buffer, dag);
+    }
+
+    std::stable_sort(buffered.begin(), buffered.end(), byCapacity);
+    mergeSorted(solutions, buffered, scratch.Merged);
+    std::swap(solutions, scratch.Merged);
+    pruneDominated(solutions);
+    if (approximate) {
+      using NumericT = typename NetT::NumericTy;
+      auto loss =
+          pruneApproximate(solutions, net.RATTolerance, net.CapacityBucket);
+      bound.prune(NumericT::toFloat(wire.DelayPerC),
+                  NumericT::toFloat(loss.RAT),
+                  NumericT::toFloat(loss.Capacity), net.WeakestR);
+      bound.cap(solutions);
+    }
+  }
+
+  if (approximate)
+    net.LossBounds[top] = bound;
+  net.store(top, std::move(solutions));
+}
+
+// Copies the records reachable from records into dag and points records to
+// the copies. Buffer records are passed through map on the way, records
+// shared by several entries are copied once.
+template <typename MapT>
+static void copyRecords(std::span<const CandidateRecordTy *> records,
+                        CandidateDAG &dag, MapT map) {
+  std::unordered_map<const CandidateRecordTy *, const CandidateRecordTy *>
+      copies{{nullptr, nullptr}};
+  std::vector<const CandidateRecordTy *> stack;
+  for (auto &record : records) {
+    stack.push_back(record);
+    while (!stack.empty()) {
+      auto top = stack.back();
+      if (copies.contains(top)) {
+        stack.pop_back();
+        continue;
+      }
+      bool ready = true;
+      for (auto child : {top->Lhs, top->Rhs}) {
+        if (!copies.contains(child)) {
+          stack.push_back(child);
+          ready = false;
+        }
+      }
+      if (!ready)
+        continue;
+      stack.pop_back();
+
+      if (top->Kind == CandidateRecordTy::KindTy::Join) {
+        copies[top] = dag.join(copies[top->Lhs], copies[top->Rhs]);
+        continue;
+      }
+      auto copy = *top;
+      map(copy);
+      copies[top] = dag.addBuffer(copies[top->Lhs], copy.Capacity, copy.RAT,
+                                  copy.P, copy.EId, *copy.Buffer);
+    }
+    record = copies[record];
   }
-  return solutions;
+}
+
+// Bound of a subtree whose frontier came from a SubtreeCache, so that what
+// its pruning passes lost is unknown: each of them may have lost all that
+// the approximation allows.
+template <typename NetT>
+static LossBoundTy subtreeLossBound(const NetT &net, NodeTy::NodeIdTy top) {
+  using NumericT = typename NetT::NumericTy;
+
+  const auto &F = net.F;
+  const auto &approximation = net.Approximation;
+
+  std::unordered_map<NodeTy::NodeIdTy, LossBoundTy> bounds;
+  for (auto node : F.getPostOrder(top)) {
+    auto &bound = bounds[node];
+    for (auto child : F.getChildNodes(node))
+      bound.join(bounds[child], net.WeakestR);
+    if (node == top)
+      break;
+    PointTy position = F.getNode(node).P;
+    for (auto point : splitEdge(F.getPoints(F.getParent(node)),
+                                net.Candidates)) {
+      auto wire = net.Timing.wire(position.distance(point));
+      position = point;
+      bound.prune(NumericT::toFloat(wire.DelayPerC),
+                  approximation.RATTolerance, approximation.CapacityBucket,
+                  net.WeakestR);
+    }
+  }
+  return bounds[top];
 }
 
 namespace algo {
 
-SolutionTy bufferInsertion(const RCGraphTy &G, unsigned step) {
-  std::vector<NodeTy::NodeIdTy> backtrack{G.getRoot()};
-  std::unordered_map<NodeTy::NodeIdTy, std::vector<SolutionTy>> visited{
-      {RCGraphTy::invalidNodeId(), {}}};
-
-  while (!backtrack.empty()) {
-    auto top = backtrack.back();
-
-    std::vector<NodeTy::NodeIdTy> children;
-    std::transform(G.getChildren(top).begin(), G.getChildren(top).end(),
-                   std::back_inserter(children),
-                   [&G](const EdgeTy::EdgeIdTy edge_id) {
-                     return G.getEdgeNodeLast(edge_id);
-                   });
-
-    std::vector<std::vector<SolutionTy>> children_solutions;
-    for (auto child : children) {
-      auto solution_it = visited.find(child);
-      if (solution_it == visited.end())
-        backtrack.push_back(child);
-      else
-        children_solutions.push_back(solution_it->second);
+// Connects a net to a subtree cache. Every node but the root gets the id of
+// its subtree, together with its parent edge, and the RAT offset of the
+// subtree, the smallest RAT of its sinks. Subtrees with less than MinWork
+// candidate points are cheaper to solve than to copy, so they are only
+// given ids, which the subtrees above them are built from.
+template <typename NetT> class SubtreeReuse final {
+  using NumericT = typename NetT::NumericTy;
+  using ValueTy = typename NetT::ValueTy;
+  using FrontierTy = typename NetT::FrontierTy;
+  using StoreTy = std::vector<FrontierTy>;
+  using IdTy = SubtreeCache::IdTy;
+
+  static constexpr size_t MinWork = 32;
+
+  SubtreeCache &Cache;
+  const FrozenRCGraph &F;
+  std::span<const size_t> Weight;
+  const Module *Library;
+  std::vector<IdTy> Ids;
+  std::vector<ValueTy> Offsets;
+
+  static std::uint64_t bits(ValueTy value) {
+    if constexpr (sizeof(ValueTy) == sizeof(std::uint32_t))
+      return std::bit_cast<std::uint32_t>(value);
+    else
+      return std::bit_cast<std::uint64_t>(value);
+  }
+
+  static std::uint64_t bits(PointTy point) {
+    return std::uint64_t{static_cast<std::uint32_t>(point.X)} << 32 |
+           static_cast<std::uint32_t>(point.Y);
+  }
+
+  StoreTy &getStore() { return *std::any_cast<StoreTy>(&Cache.Frontiers); }
+
+  bool isWorthIt(NodeTy::NodeIdTy node) const {
+    return Ids[node] != SubtreeCache::invalidId() && Weight[node] >= MinWork;
+  }
+
+  // The key of a sink is its load, the key of any other node lists its
+  // children with their offsets relative to its own. Both end with the
+  // points of the parent edge relative to the node.
+  void intern(NodeTy::NodeIdTy top, SubtreeCache::KeyTy &key) {
+    const auto &node = F.getNode(top);
+    auto children = F.getChildNodes(top);
+    key.clear();
+    if (node.Kind == NodeKindTy::Point) {
+      Offsets[top] = NumericT::fromFloat(node.RAT);
+      key.push_back(0);
+      key.push_back(bits(NumericT::fromFloat(node.Capacity)));
+    } else {
+      Offsets[top] = Offsets[children.front()];
+      for (auto child : children) {
+        if (Ids[child] == SubtreeCache::invalidId())
+          return;
+        Offsets[top] = std::min(Offsets[top], Offsets[child]);
+      }
+      key.push_back(children.size());
+      for (auto child : children) {
+        key.push_back(Ids[child]);
+        key.push_back(bits(NumericT::sub(Offsets[child], Offsets[top])));
+      }
+    }
+    auto points = F.getPoints(F.getParent(top));
+    key.push_back(points.size());
+    for (auto point : points)
+      key.push_back(bits(PointTy{point.X - node.P.X, point.Y - node.P.Y}));
+
+    auto found = Cache.Ids.find(key);
+    if (found != Cache.Ids.end()) {
+      Ids[top] = found->second;
+      return;
+    }
+    if (Cache.isFull())
+      return;
+    Ids[top] = Cache.Ids.size();
+    Cache.Ids.emplace(key, Ids[top]);
+    Cache.Bytes += sizeof(SubtreeCache::KeyTy) + sizeof(IdTy) +
+                   key.size() * sizeof(std::uint64_t);
+  }
+
+public:
+  SubtreeReuse(SubtreeCache &cache, const NetT &net,
+               std::span<const size_t> weight)
+      : Cache{cache}, F{net.F}, Weight{weight},
+        Library{net.F.getAttrs().getModules(ModuleKind::Buffer).data()},
+        Ids(F.getNodeIdBound(), SubtreeCache::invalidId()),
+        Offsets(F.getNodeIdBound()) {
+    std::unique_lock guard{Cache.Mutex};
+    Cache.bind(typeid(NetT), F.getAttrs(), net.Candidates, net.Approximation);
+    if (!Cache.Frontiers.has_value())
+      Cache.Frontiers = StoreTy{};
+
+    SubtreeCache::KeyTy key;
+    for (auto top : F.getPostOrder())
+      if (top != F.getRoot())
+        intern(top, key);
+  }
+
+  // Stores the frontier of the subtree of top in the net if the cache keeps
+  // it, with records copied to dag.
+  bool reuse(NetT &net, NodeTy::NodeIdTy top, CandidateDAG &dag) {
+    if (!isWorthIt(top))
+      return false;
+    FrontierTy frontier;
+    {
+      std::shared_lock guard{Cache.Mutex};
+      auto &store = getStore();
+      if (Ids[top] >= store.size() || store[Ids[top]].empty())
+        return false;
+      frontier = store[Ids[top]];
+    }
+    Cache.Hits.fetch_add(1, std::memory_order_relaxed);
+    net.ReusedSubtrees.fetch_add(1, std::memory_order_relaxed);
+
+    auto offset = Offsets[top];
+    for (auto &rat : frontier.RAT)
+      rat = NumericT::add(rat, offset);
+
+    // Records kept by the cache do not change, so they are read unlocked.
+    auto root = F.getNode(top).P;
+    auto post_order = F.getPostOrder(top);
+    auto rat_offset = NumericT::toFloat(offset);
+    copyRecords(frontier.Records, dag, [&](CandidateRecordTy &record) {
+      record.P = PointTy{record.P.X + root.X, record.P.Y + root.Y};
+      record.EId = F.getParent(post_order[record.EId]);
+      record.Buffer = Library + (record.Buffer - Cache.Library.data());
+      record.RAT += rat_offset;
+    });
+    if (!net.Approximation.isExact()) {
+      net.LossBounds[top] = subtreeLossBound(net, top);
+      net.LossBounds[top].cap(frontier);
+    }
+    net.store(top, std::move(frontier));
+    return true;
+  }
+
+  // Hands the frontier of the solved subtree of top to the cache, unless it
+  // already keeps one or is full.
+  void keep(const NetT &net, NodeTy::NodeIdTy top) {
+    if (!isWorthIt(top))
+      return;
+    {
+      std::shared_lock guard{Cache.Mutex};
+      auto &store = getStore();
+      if (Cache.isFull() ||
+          (Ids[top] < store.size() && !store[Ids[top]].empty()))
+        return;
+    }
+
+    auto frontier = net.Frontiers[top];
+    auto offset = Offsets[top];
+    for (auto &rat : frontier.RAT)
+      rat = NumericT::sub(rat, offset);
+
+    auto root = F.getNode(top).P;
+    auto first = F.getPostIndex(top) + 1 - F.getPostOrder(top).size();
+    const auto &G = F.getGraph();
+    auto rat_offset = NumericT::toFloat(offset);
+    auto map = [&](CandidateRecordTy &record) {
+      record.P = PointTy{record.P.X - root.X, record.P.Y - root.Y};
+      record.EId = F.getPostIndex(G.getEdgeNodeLast(record.EId)) - first;
+      record.Buffer = Cache.Library.data() + (record.Buffer - Library);
+      record.RAT -= rat_offset;
+    };
+
+    std::unique_lock guard{Cache.Mutex};
+    auto &store = getStore();
+    if (Cache.isFull())
+      return;
+    if (store.size() <= Ids[top])
+      store.resize(Cache.Ids.size());
+    if (!store[Ids[top]].empty())
+      return;
+    auto records = Cache.Records.getStats().BytesUsed;
+    copyRecords(frontier.Records, Cache.Records, map);
+    Cache.Bytes += frontier.bytes() + Cache.Records.getStats().BytesUsed -
+                   records;
+    store[Ids[top]] = std::move(frontier);
+    ++Cache.NumFrontiers;
+  }
+};
+
+} // namespace algo
+
+// With reuse, subtrees the cache keeps are not solved. The outermost one of
+// the subtrees that start at a node is looked up first.
+template <typename NetT>
+static void solveSubtree(NetT &net, NodeTy::NodeIdTy subtree_root,
+                         CandidateDAG &dag,
+                         SubtreeReuse<NetT> *reuse = nullptr) {
+  ScratchTy<NetT> scratch;
+  const auto &F = net.F;
+  auto post_order = F.getPostOrder(subtree_root);
+  if (!reuse) {
+    for (auto top : post_order)
+      solveNode(net, top, dag, scratch);
+    return;
+  }
+
+  std::vector<NodeTy::NodeIdTy> starting;
+  for (size_t idx = 0; idx != post_order.size();) {
+    // Empty unless post_order[idx] is a leaf.
+    auto begin = post_order.data() + idx;
+    starting.clear();
+    for (auto node = post_order[idx]; F.getPostOrder(node).data() == begin;
+         node = F.getParentNode(node)) {
+      starting.push_back(node);
+      if (node == subtree_root)
+        break;
     }
 
-    if (children_solutions.size() < children.size())
+    auto reused = std::find_if(
+        starting.rbegin(), starting.rend(),
+        [&](NodeTy::NodeIdTy node) { return reuse->reuse(net, node, dag); });
+    if (reused != starting.rend()) {
+      idx += F.getPostOrder(*reused).size();
       continue;
+    }
+    solveNode(net, post_order[idx], dag, scratch);
+    reuse->keep(net, post_order[idx]);
+    ++idx;
+  }
+}
+
+template <typename NetT>
+static SolutionTy finalize(NetT &net, std::span<const CandidateDAG> dags,
+                           EngineStatsTy *stats) {
+  using NumericT = typename NetT::NumericTy;
+
+  const auto &F = net.F;
+  const auto &timing = net.Timing;
+
+  auto solutions = net.take(F.getRoot());
+  if (stats) {
+    stats->PeakFrontierBytes = net.PeakBytes;
+    stats->ReusedSubtrees = net.ReusedSubtrees;
+    stats->RATLossBound = net.Approximation.isExact()
+                              ? 0
+                              : net.LossBounds[F.getRoot()].Loss;
+    stats->Records = {};
+    for (auto &dag : dags)
+      stats->Records += dag.getStats();
+  }
+  assert(!solutions.empty());
+  auto best_solution = solutions[0];
+  insert(timing, best_solution, timing.getDriver());
+  for (size_t idx = 1; idx != solutions.size(); ++idx) {
+    auto solution = solutions[idx];
+    insert(timing, solution, timing.getDriver());
+    if (solution.RAT > best_solution.RAT)
+      best_solution = solution;
+  }
+
+  return collectSolution({NumericT::toFloat(best_solution.Capacity),
+                          NumericT::toFloat(best_solution.RAT),
+                          best_solution.Record},
+                         F.getNode(F.getRoot()).P);
+}
+
+// Number of candidate points of an edge, a rough measure of the work spent on
+// buffering it.
+static size_t edgeWeight(std::span<const PointTy> points,
+                         const CandidatePolicyTy &candidates) {
+  using KindTy = CandidatePolicyTy::KindTy;
+
+  switch (candidates.Kind) {
+  case KindTy::Step:
+    return edgeLength(points) / candidates.Step + 1;
+  case KindTy::Relative:
+    return edgeLength(points) / relativeStep(points, candidates.Fraction) + 1;
+  case KindTy::MaxPerEdge:
+    return std::max(candidates.Count, 1u);
+  case KindTy::Bends:
+    return points.size() * (candidates.Count + 1);
+  }
+  return 1;
+}
+
+// Candidate points of every subtree together with its parent edge.
+static std::vector<size_t> subtreeWeights(const FrozenRCGraph &F,
+                                          const CandidatePolicyTy &candidates) {
+  std::vector<size_t> weight(F.getNodeIdBound());
+  for (auto node : F.getPostOrder()) {
+    weight[node] += 1;
+    if (node != F.getRoot()) {
+      weight[node] += edgeWeight(F.getPoints(F.getParent(node)), candidates);
+      weight[F.getParentNode(node)] += weight[node];
+    }
+  }
+  return weight;
+}
+
+namespace {
+
+// Buffers below an entry and their total area. A cost that a run does not
+// count is kept at 0.
+struct LayerCostTy {
+  unsigned Buffers = 0;
+  NodeTy::FloatTy Area = 0;
+
+  auto operator<=>(const LayerCostTy &) const = default;
+
+  bool atMost(const LayerCostTy &other) const {
+    return Buffers <= other.Buffers && Area <= other.Area;
+  }
+};
+
+// Frontier of the entries of a node with the same cost.
+template <typename NetT> struct LayerTy {
+  LayerCostTy Cost;
+  typename NetT::FrontierTy Solutions;
+};
+
+// Frontiers of a node by the cost of the buffers below it, ordered by cost.
+// A layer holds the entries that no entry of a layer costing at most as much
+// in both dominates, so an entry survives only if it saves capacity, RAT,
+// buffers or area.
+template <typename NetT> using LayersTy = std::vector<LayerTy<NetT>>;
+
+// Layers of a trade-off run, solved node by node on a single thread.
+template <typename NetT> struct LayeredFrontiersTy {
+  std::vector<LayersTy<NetT>> Frontiers;
+  size_t LiveBytes = 0;
+  size_t PeakBytes = 0;
 
-    auto solutions = mergeSolutions(children_solutions, G.getNode(top));
-    solutions = redundancy_elimination(std::move(solutions));
+  // Costs that tell layers apart.
+  bool CountBuffers = true;
+  bool CountArea = true;
+  // The number of buffers of a layer stops at MaxLayers - 1, so that layer
+  // holds every entry with at least that many. Only the layers below it are
+  // exact in the number of buffers, but no entry is lost.
+  size_t MaxLayers = std::numeric_limits<size_t>::max();
+  // Entries that no buffer brings up to Target are dropped.
+  std::optional<typename NetT::ValueTy> Target;
 
-    LOG_NODE(G.getNode(top), solutions);
+  explicit LayeredFrontiersTy(const FrozenRCGraph &F)
+      : Frontiers(F.getNodeIdBound()) {}
 
-    if (top == G.getRoot()) {
-      for (auto &solution : solutions) {
-        insert(solution, G);
-        solution.back().HasBuffer = false;
+  LayerCostTy add(const LayerCostTy &lhs, const LayerCostTy &rhs) const {
+    return {static_cast<unsigned>(std::min<size_t>(lhs.Buffers + rhs.Buffers,
+                                                   MaxLayers - 1)),
+            lhs.Area + rhs.Area};
+  }
+
+  LayerCostTy cost(const Module &buffer) const {
+    return {CountBuffers ? 1u : 0u, CountArea ? buffer.Area : 0};
+  }
+
+  static size_t bytes(const LayersTy<NetT> &layers) {
+    size_t size = layers.capacity() * sizeof(LayerTy<NetT>);
+    for (auto &layer : layers)
+      size += layer.Solutions.bytes();
+    return size;
+  }
+
+  void store(NodeTy::NodeIdTy node, LayersTy<NetT> &&layers) {
+    LiveBytes += bytes(layers);
+    PeakBytes = std::max(PeakBytes, LiveBytes);
+    Frontiers[node] = std::move(layers);
+  }
+
+  LayersTy<NetT> take(NodeTy::NodeIdTy node) {
+    auto layers = std::move(Frontiers[node]);
+    LiveBytes -= bytes(layers);
+    return layers;
+  }
+};
+
+} // namespace
+
+// Frontier of the layer of cost, added empty if there is none.
+template <typename NetT>
+static typename NetT::FrontierTy &layerOf(LayersTy<NetT> &layers,
+                                          const LayerCostTy &cost) {
+  auto it = std::lower_bound(
+      layers.begin(), layers.end(), cost,
+      [](const LayerTy<NetT> &layer, const LayerCostTy &cost) {
+        return layer.Cost < cost;
+      });
+  if (it == layers.end() || it->Cost != cost)
+    it = layers.insert(it, LayerTy<NetT>{cost, {}});
+  return it->Solutions;
+}
+
+// Adds the pruned frontier from to the pruned frontier into. Entries are
+// taken in the order of capacity, the one with more RAT first on equal
+// capacity, and kept if they improve RAT.
+template <typename NetT>
+static void unite(typename NetT::FrontierTy &into,
+                  const typename NetT::FrontierTy &from,
+                  ScratchTy<NetT> &scratch) {
+  if (into.empty()) {
+    into = from;
+    return;
+  }
+  auto &united = scratch.Merged;
+  united.clear();
+  united.reserve(into.size() + from.size());
+  size_t lhs = 0;
+  size_t rhs = 0;
+  while (lhs != into.size() || rhs != from.size()) {
+    bool take_lhs =
+        rhs == from.size() ||
+        (lhs != into.size() &&
+         (into.Capacity[lhs] < from.Capacity[rhs] ||
+          (into.Capacity[lhs] == from.Capacity[rhs] &&
+           into.RAT[lhs] >= from.RAT[rhs])));
+    auto entry = take_lhs ? into[lhs++] : from[rhs++];
+    if (united.empty() || entry.RAT > united.RAT.back())
+      united.push_back(entry);
+  }
+  std::swap(into, united);
+}
+
+// Trade-off runs drop most of the entries they make right after making them,
+// so the records of new entries are staged in the scratch first and only
+// those of kept entries are copied into the DAG. Staged records never point
+// to each other.
+template <typename NetT>
+static void stage(ScratchTy<NetT> &scratch, size_t count) {
+  scratch.Staged.clear();
+  scratch.Staged.reserve(count);
+}
+
+template <typename NetT>
+static const CandidateRecordTy *stageRecord(ScratchTy<NetT> &scratch,
+                                            const CandidateRecordTy &record) {
+  assert(scratch.Staged.size() != scratch.Staged.capacity());
+  return &scratch.Staged.emplace_back(record);
+}
+
+template <typename NetT>
+static void keepStaged(LayersTy<NetT> &layers, ScratchTy<NetT> &scratch,
+                       CandidateDAG &dag) {
+  auto staged = std::span{scratch.Staged};
+  for (auto &[cost, layer] : layers)
+    for (auto &record : layer.Records)
+      if (!staged.empty() && record >= &staged.front() &&
+          record <= &staged.back())
+        record = dag.add(*record);
+}
+
+// Best RAT among the entries added so far whose layer costs at most a given
+// one in both buffers and area. The costs of all layers are known up front,
+// so a Fenwick tree over buffer counts holds in every node a Fenwick tree over
+// the areas of the costs that node covers. The cells that each layer updates
+// and reads are listed once, and every tree lives in one array.
+template <typename ValueT> class CostDominanceTy {
+  std::vector<ValueT> Best;
+  std::vector<unsigned> AddCells;
+  std::vector<unsigned> ReachCells;
+  std::vector<unsigned> AddBegin;
+  std::vector<unsigned> ReachBegin;
+
+public:
+  template <typename NetT>
+  explicit CostDominanceTy(const LayersTy<NetT> &layers) {
+    // Layers are ordered by buffers first.
+    std::vector<unsigned> buffers;
+    for (auto &layer : layers)
+      if (buffers.empty() || buffers.back() != layer.Cost.Buffers)
+        buffers.push_back(layer.Cost.Buffers);
+    auto rank = [&](unsigned count) -> size_t {
+      return std::lower_bound(buffers.begin(), buffers.end(), count) -
+             buffers.begin() + 1;
+    };
+    std::vector<std::vector<NodeTy::FloatTy>> areas(buffers.size() + 1);
+    for (auto &layer : layers)
+      for (auto node = rank(layer.Cost.Buffers); node < areas.size();
+           node += node & -node)
+        areas[node].push_back(layer.Cost.Area);
+    std::vector<unsigned> offset(areas.size());
+    for (size_t node = 1; node != areas.size(); ++node) {
+      std::sort(areas[node].begin(), areas[node].end());
+      areas[node].erase(std::unique(areas[node].begin(), areas[node].end()),
+                        areas[node].end());
+      offset[node] = Best.size();
+      Best.resize(Best.size() + areas[node].size() + 1,
+                  std::numeric_limits<ValueT>::lowest());
+    }
+
+    for (auto &[cost, solutions] : layers) {
+      AddBegin.push_back(AddCells.size());
+      ReachBegin.push_back(ReachCells.size());
+      for (auto node = rank(cost.Buffers); node < areas.size();
+           node += node & -node) {
+        auto &node_areas = areas[node];
+        size_t first = std::lower_bound(node_areas.begin(), node_areas.end(),
+                                        cost.Area) -
+                       node_areas.begin() + 1;
+        for (auto idx = first; idx <= node_areas.size(); idx += idx & -idx)
+          AddCells.push_back(offset[node] + idx);
       }
-      visited[top] = solutions;
+      for (auto node = rank(cost.Buffers); node != 0; node -= node & -node) {
+        auto &node_areas = areas[node];
+        size_t last = std::upper_bound(node_areas.begin(), node_areas.end(),
+                                       cost.Area) -
+                      node_areas.begin();
+        for (auto idx = last; idx != 0; idx -= idx & -idx)
+          ReachCells.push_back(offset[node] + idx);
+      }
+    }
+    AddBegin.push_back(AddCells.size());
+    ReachBegin.push_back(ReachCells.size());
+  }
+
+  void add(size_t layer, ValueT rat) {
+    for (auto cell = AddBegin[layer]; cell != AddBegin[layer + 1]; ++cell)
+      Best[AddCells[cell]] = std::max(Best[AddCells[cell]], rat);
+  }
 
-      backtrack.pop_back();
-      assert(backtrack.empty());
+  // Some entry of a layer costing at most the one of layer has at least rat.
+  bool reaches(size_t layer, ValueT rat) const {
+    for (auto cell = ReachBegin[layer]; cell != ReachBegin[layer + 1]; ++cell)
+      if (Best[ReachCells[cell]] >= rat)
+        return true;
+    return false;
+  }
+};
 
+// Keeps the entries of layer that keep says to keep, in order.
+template <typename NetT, typename KeepT>
+static void compactLayer(typename NetT::FrontierTy &layer, KeepT keep) {
+  size_t kept = 0;
+  for (size_t idx = 0; idx != layer.size(); ++idx) {
+    if (!keep(idx))
       continue;
+    layer.Capacity[kept] = layer.Capacity[idx];
+    layer.RAT[kept] = layer.RAT[idx];
+    layer.Records[kept] = layer.Records[idx];
+    ++kept;
+  }
+  layer.resize(kept);
+}
+
+// Drops entries that an entry of a cheaper layer dominates, then empty
+// layers. Every layer must be pruned on its own.
+template <typename NetT>
+static void pruneLayers(LayersTy<NetT> &layers, ScratchTy<NetT> &scratch) {
+  bool chain = std::adjacent_find(layers.begin(), layers.end(),
+                                  [](auto &lhs, auto &rhs) {
+                                    return !lhs.Cost.atMost(rhs.Cost);
+                                  }) == layers.end();
+  if (chain) {
+    // Every layer before the current one is cheaper. fewer is their union,
+    // pruned, so the last entry up to a capacity has the best RAT.
+    auto &fewer = scratch.Fewer;
+    fewer.clear();
+    for (auto &[cost, layer] : layers) {
+      size_t pos = 0;
+      compactLayer<NetT>(layer, [&](size_t idx) {
+        while (pos != fewer.size() &&
+               fewer.Capacity[pos] <= layer.Capacity[idx])
+          ++pos;
+        return pos == 0 || fewer.RAT[pos - 1] < layer.RAT[idx];
+      });
+      unite(fewer, layer, scratch);
+    }
+  } else {
+    // Entries of all layers by capacity, the one with more RAT and then the
+    // cheaper one first, each checked against those before it.
+    struct OrderTy {
+      typename NetT::ValueTy Capacity;
+      typename NetT::ValueTy RAT;
+      unsigned Layer;
+      unsigned Idx;
+    };
+    std::vector<OrderTy> order;
+    for (unsigned layer = 0; layer != layers.size(); ++layer) {
+      auto &solutions = layers[layer].Solutions;
+      for (unsigned idx = 0; idx != solutions.size(); ++idx)
+        order.push_back(
+            {solutions.Capacity[idx], solutions.RAT[idx], layer, idx});
     }
+    std::sort(order.begin(), order.end(), [](auto &lhs, auto &rhs) {
+      if (lhs.Capacity != rhs.Capacity)
+        return lhs.Capacity < rhs.Capacity;
+      if (lhs.RAT != rhs.RAT)
+        return lhs.RAT > rhs.RAT;
+      return lhs.Layer < rhs.Layer;
+    });
+    CostDominanceTy<typename NetT::ValueTy> cheaper{layers};
+    std::vector<std::vector<bool>> keep(layers.size());
+    for (size_t layer = 0; layer != layers.size(); ++layer)
+      keep[layer].resize(layers[layer].Solutions.size());
+    for (auto &entry : order) {
+      if (cheaper.reaches(entry.Layer, entry.RAT))
+        continue;
+      keep[entry.Layer][entry.Idx] = true;
+      cheaper.add(entry.Layer, entry.RAT);
+    }
+    for (size_t layer = 0; layer != layers.size(); ++layer)
+      compactLayer<NetT>(layers[layer].Solutions,
+                         [&](size_t idx) { return keep[layer][idx]; });
+  }
+  std::erase_if(layers, [](auto &layer) { return layer.Solutions.empty(); });
+}
 
-    EdgeTy::EdgeIdTy edge_id = G.getParent(top);
-    PointsTy points = splitEdge(G.getEdge(edge_id), step);
+// The stage that drives an entry delays it by at least the delay of some
+// buffer driving its capacity, and every wire only adds to that.
+template <typename NetT>
+static void pruneTarget(const NetT &net, LayersTy<NetT> &layers,
+                        typename NetT::ValueTy target) {
+  const auto &timing = net.Timing;
+  auto buffers = timing.getBuffers();
+  for (auto &[cost, layer] : layers)
+    compactLayer<NetT>(layer, [&](size_t idx) {
+      return std::any_of(buffers.begin(), buffers.end(), [&](auto &buffer) {
+        return timing.bufferedRAT(buffer, layer.RAT[idx],
+                                  layer.Capacity[idx]) >= target;
+      });
+    });
+  std::erase_if(layers, [](auto &layer) { return layer.Solutions.empty(); });
+}
 
-    for (auto &point : points) {
-      auto last_candidate = solutions.back().back();
-      unsigned length = last_candidate.P.distance(point);
-      for (auto &solution : solutions)
-        insert(solution, length, point, edge_id, G);
+template <typename NetT>
+static LayersTy<NetT> mergeLayers(LayeredFrontiersTy<NetT> &frontiers,
+                                  const LayersTy<NetT> &lhs,
+                                  const LayersTy<NetT> &rhs,
+                                  CandidateDAG &dag, ScratchTy<NetT> &scratch) {
+  using FrontierT = typename NetT::FrontierTy;
+  using NumericT = typename NetT::NumericTy;
 
-      solutions = redundancy_elimination(std::move(solutions));
+  size_t count = 0;
+  for (auto &lhs_layer : lhs)
+    for (auto &rhs_layer : rhs)
+      count += lhs_layer.Solutions.size() + rhs_layer.Solutions.size();
+  stage(scratch, count);
 
-      auto copy_solutions = solutions;
-      for (auto &copy_solution : copy_solutions)
-        insert(copy_solution, G);
+  // Same as mergeFrontiers, with staged joins.
+  auto join = [&](const FrontierT &lhs, const FrontierT &rhs,
+                  FrontierT &joined) {
+    joined.clear();
+    size_t lhs_idx = 0;
+    size_t rhs_idx = 0;
+    while (lhs_idx != lhs.size() && rhs_idx != rhs.size()) {
+      auto lhs_rat = lhs.RAT[lhs_idx];
+      auto rhs_rat = rhs.RAT[rhs_idx];
+      auto capacity =
+          NumericT::add(lhs.Capacity[lhs_idx], rhs.Capacity[rhs_idx]);
+      if (!joined.empty() && joined.Capacity.back() >= capacity)
+        joined.pop_back();
+      auto lhs_record = lhs.Records[lhs_idx];
+      auto rhs_record = rhs.Records[rhs_idx];
+      auto record = lhs_record && rhs_record
+                        ? stageRecord(scratch,
+                                      {.Kind = CandidateRecordTy::KindTy::Join,
+                                       .Lhs = lhs_record,
+                                       .Rhs = rhs_record,
+                                       .Capacity = {},
+                                       .RAT = {},
+                                       .P = PointTy{0, 0},
+                                       .EId = RCGraphTy::invalidEdgeId(),
+                                       .Buffer = nullptr})
+                        : (lhs_record ? lhs_record : rhs_record);
+      joined.push_back({capacity, std::min(lhs_rat, rhs_rat), record});
 
-      std::move(copy_solutions.begin(), copy_solutions.end(),
-                std::back_inserter(solutions));
-      solutions = redundancy_elimination(std::move(solutions));
+      if (lhs_rat <= rhs_rat)
+        ++lhs_idx;
+      if (rhs_rat <= lhs_rat)
+        ++rhs_idx;
     }
+  };
 
-    visited[top] = solutions;
-    backtrack.pop_back();
-  }
-  /*
-  for (auto &[id, solutions] : visited) {
-    std::cout << "NODE = " << id << std::endl;
-    for (auto &solution : solutions) {
-      std::cout << "Solution" << std::endl;
-      for (auto candidate : solution)
-        std::cout << candidate << "\n";
-      std::cout << std::endl;
+  LayersTy<NetT> merged;
+  FrontierT joined;
+  for (auto &lhs_layer : lhs)
+    for (auto &rhs_layer : rhs) {
+      join(lhs_layer.Solutions, rhs_layer.Solutions, joined);
+      unite(layerOf(merged, frontiers.add(lhs_layer.Cost, rhs_layer.Cost)),
+            joined, scratch);
     }
-    std::cout << std::endl;
+  pruneLayers(merged, scratch);
+  keepStaged(merged, scratch, dag);
+  return merged;
+}
+
+// Same as solveNode, except that a buffer moves the entry it drives to the
+// layer of its cost plus the one of the buffer.
+template <typename NetT>
+static void solveLayeredNode(NetT &net, LayeredFrontiersTy<NetT> &frontiers,
+                             NodeTy::NodeIdTy top, CandidateDAG &dag,
+                             ScratchTy<NetT> &scratch) {
+  using NumericT = typename NetT::NumericTy;
+
+  const auto &F = net.F;
+  const auto timing = net.Timing;
+
+  const auto &node = F.getNode(top);
+  LayersTy<NetT> layers(1);
+  if (node.Kind == NodeKindTy::Point) {
+    layers[0].Solutions.push_back({NumericT::fromFloat(node.Capacity),
+                                   NumericT::fromFloat(node.RAT), nullptr});
+  } else {
+    auto children = F.getChildNodes(top);
+    layers = frontiers.take(children.front());
+    for (auto child : children.subspan(1))
+      layers =
+          mergeLayers(frontiers, layers, frontiers.take(child), dag, scratch);
   }
-*/
-  std::vector<SolutionTy> solutions = visited[G.getRoot()];
+  if (frontiers.Target)
+    pruneTarget(net, layers, *frontiers.Target);
 
-  auto best_solution = std::max_element(
-      solutions.begin(), solutions.end(), [](const auto &lhs, const auto &rhs) {
-        return lhs.back().RAT < rhs.back().RAT;
+  if (top == F.getRoot()) {
+    frontiers.store(top, std::move(layers));
+    return;
+  }
+
+  EdgeTy::EdgeIdTy edge_id = F.getParent(top);
+  PointsTy points = splitEdge(F.getPoints(edge_id), net.Candidates);
+
+  // Entries buffered at a point with the cost of their new layer. All of
+  // them are taken before any is added, so that no entry is buffered twice.
+  std::vector<std::pair<LayerCostTy, typename NetT::EntryTy>> buffered;
+  PointTy position = node.P;
+  for (auto &point : points) {
+    unsigned length = position.distance(point);
+    position = point;
+    auto wire = timing.wire(length);
+    buffered.clear();
+    stage(scratch, layers.size() * timing.getBuffers().size());
+    for (auto &[cost, solutions] : layers) {
+      addWire(solutions, wire.ConstDelay, wire.DelayPerC, wire.AddC);
+      pruneDominated(solutions);
+      buildHull(solutions, scratch.Hull);
+      for (auto &buffer : timing.getBuffers()) {
+        auto entry =
+            solutions[findBestDriven(timing, solutions, scratch.Hull, buffer)];
+        insert(timing, entry, buffer);
+        entry.Record = stageRecord(
+            scratch, {.Kind = CandidateRecordTy::KindTy::Buffer,
+                      .Lhs = entry.Record,
+                      .Rhs = nullptr,
+                      .Capacity = NumericT::toFloat(entry.Capacity),
+                      .RAT = NumericT::toFloat(entry.RAT),
+                      .P = point,
+                      .EId = edge_id,
+                      .Buffer = buffer.Cell});
+        buffered.emplace_back(frontiers.add(cost, frontiers.cost(*buffer.Cell)),
+                              entry);
+      }
+    }
+
+    std::stable_sort(buffered.begin(), buffered.end(),
+                     [](auto &lhs, auto &rhs) {
+                       if (lhs.first != rhs.first)
+                         return lhs.first < rhs.first;
+                       return byCapacity(lhs.second, rhs.second);
+                     });
+    for (auto first = buffered.begin(); first != buffered.end();) {
+      auto last = std::find_if(first, buffered.end(), [&](auto &entry) {
+        return entry.first != first->first;
       });
-  return *best_solution;
+      auto &entries = scratch.Buffered;
+      entries.clear();
+      for (auto it = first; it != last; ++it)
+        entries.push_back(it->second);
+      auto &solutions = layerOf(layers, first->first);
+      mergeSorted(solutions, entries, scratch.Merged);
+      std::swap(solutions, scratch.Merged);
+      pruneDominated(solutions);
+      first = last;
+    }
+    pruneLayers(layers, scratch);
+    if (frontiers.Target)
+      pruneTarget(net, layers, *frontiers.Target);
+    keepStaged(layers, scratch, dag);
+  }
+
+  frontiers.store(top, std::move(layers));
+}
+
+// Buffers below record and their total area.
+static LayerCostTy recordCost(const CandidateRecordTy *record) {
+  LayerCostTy cost;
+  std::vector<const CandidateRecordTy *> stack;
+  if (record)
+    stack.push_back(record);
+  while (!stack.empty()) {
+    auto top = stack.back();
+    stack.pop_back();
+    if (top->Kind == CandidateRecordTy::KindTy::Buffer) {
+      ++cost.Buffers;
+      cost.Area += top->Buffer->Area;
+    }
+    if (top->Rhs)
+      stack.push_back(top->Rhs);
+    if (top->Lhs)
+      stack.push_back(top->Lhs);
+  }
+  return cost;
 }
 
+// Root entries driven by the driver, without those that another entry beats
+// on RAT, buffers and area.
+template <typename NetT>
+static TradeOffTy finalizeTradeOff(NetT &net,
+                                   LayeredFrontiersTy<NetT> &frontiers,
+                                   const CandidateDAG &dag,
+                                   EngineStatsTy *stats) {
+  using NumericT = typename NetT::NumericTy;
+
+  const auto &F = net.F;
+  const auto &timing = net.Timing;
+
+  auto layers = frontiers.take(F.getRoot());
+  if (stats) {
+    stats->PeakFrontierBytes = frontiers.PeakBytes;
+    stats->Records = dag.getStats();
+  }
+
+  // Entries are compared on the RAT they report, which fixed-point RATs
+  // may share.
+  struct RootEntryTy {
+    typename NetT::EntryTy Entry;
+    NodeTy::FloatTy RAT;
+    LayerCostTy Cost;
+  };
+  std::vector<RootEntryTy> entries;
+  for (auto &[cost, solutions] : layers)
+    for (size_t idx = 0; idx != solutions.size(); ++idx) {
+      auto entry = solutions[idx];
+      insert(timing, entry, timing.getDriver());
+      // The cost of the layer may stop short of the buffers or not count
+      // them at all.
+      bool exact = frontiers.CountBuffers && frontiers.CountArea &&
+                   cost.Buffers + 1 < frontiers.MaxLayers;
+      entries.push_back({entry, NumericT::toFloat(entry.RAT),
+                         exact ? cost : recordCost(entry.Record)});
+    }
+
+  std::stable_sort(entries.begin(), entries.end(), [](auto &lhs, auto &rhs) {
+    if (lhs.RAT != rhs.RAT)
+      return lhs.RAT > rhs.RAT;
+    return lhs.Cost < rhs.Cost;
+  });
+  // Every kept entry has at least the RAT of the current one. Of their costs
+  // only the staircase of those that no other one is at most is kept, by
+  // buffers, so that the area falls along it.
+  std::map<unsigned, NodeTy::FloatTy> cheapest;
+  TradeOffTy points;
+  for (auto &[entry, rat, cost] : entries) {
+    auto it = cheapest.upper_bound(cost.Buffers);
+    if (it != cheapest.begin() && std::prev(it)->second <= cost.Area)
+      continue;
+    while (it != cheapest.end() && it->second >= cost.Area)
+      it = cheapest.erase(it);
+    cheapest[cost.Buffers] = cost.Area;
+    points.push_back({rat, cost.Buffers, cost.Area,
+                      collectSolution({NumericT::toFloat(entry.Capacity),
+                                       NumericT::toFloat(entry.RAT),
+                                       entry.Record},
+                                      F.getNode(F.getRoot()).P)});
+  }
+  return points;
+}
+
+namespace algo {
+
+template <typename NumericT, typename DelayModelT>
+SolutionTy bufferInsertion(const RCGraphTy &G,
+                           const CandidatePolicyTy &candidates,
+                           const ApproximationTy &approximation,
+                           EngineStatsTy *stats, SubtreeCache *cache) {
+  using NetT = NetStateTy<NumericT, DelayModelT>;
+
+  auto &dag = acquireThreadDAG();
+  auto F = freeze(G);
+  NetT net{F, candidates, approximation};
+  if (!cache) {
+    solveSubtree(net, F.getRoot(), dag);
+    return finalize(net, {&dag, 1}, stats);
+  }
+
+  auto weight = subtreeWeights(F, candidates);
+  SubtreeReuse<NetT> reuse{*cache, net, weight};
+  solveSubtree(net, F.getRoot(), dag, &reuse);
+  return finalize(net, {&dag, 1}, stats);
+}
+
+template <typename NumericT, typename DelayModelT>
+SolutionTy bufferInsertion(const RCGraphTy &G, ThreadPool &pool,
+                           unsigned grain,
+                           const CandidatePolicyTy &candidates,
+                           const ApproximationTy &approximation,
+                           EngineStatsTy *stats, SubtreeCache *cache) {
+  using NetT = NetStateTy<NumericT, DelayModelT>;
+
+  auto F = freeze(G);
+  NetT net{F, candidates, approximation};
+  auto weight = subtreeWeights(F, candidates);
+  std::optional<SubtreeReuse<NetT>> reuse;
+  if (cache)
+    reuse.emplace(*cache, net, weight);
+
+  if (weight[F.getRoot()] <= grain) {
+    auto &dag = acquireThreadDAG();
+    solveSubtree(net, F.getRoot(), dag, reuse ? &*reuse : nullptr);
+    return finalize(net, {&dag, 1}, stats);
+  }
+
+  // Subtrees lighter than grain are solved sequentially by a single task.
+  // Every heavier node becomes a task of its own, submitted by the task that
+  // solves its last child. Records stay alive until the solution is
+  // collected, as frontiers keep pointing to records of other workers. The
+  // last DAG holds records of heavy subtrees reused before solving starts,
+  // nodes below them are skipped.
+  std::vector<CandidateDAG> dags(pool.size() + 1);
+  std::vector<bool> skip(F.getNodeIdBound());
+  if (reuse) {
+    auto post_order = F.getPostOrder();
+    for (auto it = std::next(post_order.rbegin()); it != post_order.rend();
+         ++it) {
+      auto parent = F.getParentNode(*it);
+      skip[*it] = skip[parent] || (weight[*it] > grain &&
+                                   reuse->reuse(net, *it, dags.back()));
+    }
+  }
+  auto unsolved_children = [&](NodeTy::NodeIdTy node) {
+    auto children = F.getChildNodes(node);
+    return std::count_if(children.begin(), children.end(),
+                         [&](auto child) { return !skip[child]; });
+  };
+
+  std::vector<std::atomic<unsigned>> pending(F.getNodeIdBound());
+  for (auto node : F.getPostOrder())
+    if (weight[node] > grain && !skip[node])
+      pending[node] = unsolved_children(node);
+
+  std::function<void(NodeTy::NodeIdTy)> solved;
+  auto solve_node = [&](NodeTy::NodeIdTy node) {
+    ScratchTy<NetT> scratch;
+    solveNode(net, node, dags[pool.currentWorker()], scratch);
+    if (reuse)
+      reuse->keep(net, node);
+    solved(node);
+  };
+  solved = [&](NodeTy::NodeIdTy node) {
+    if (node == F.getRoot())
+      return;
+    auto parent = F.getParentNode(node);
+    if (pending[parent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+      pool.submit([&solve_node, parent] { solve_node(parent); });
+  };
+
+  for (auto node : F.getPostOrder()) {
+    if (skip[node])
+      continue;
+    if (weight[node] > grain) {
+      if (unsolved_children(node) == 0)
+        pool.submit([&solve_node, node] { solve_node(node); });
+      continue;
+    }
+    if (weight[F.getParentNode(node)] > grain)
+      pool.submit([&, node] {
+        solveSubtree(net, node, dags[pool.currentWorker()],
+                     reuse ? &*reuse : nullptr);
+        solved(node);
+      });
+  }
+  pool.wait();
+
+  return finalize(net, dags, stats);
+}
+
+template <typename NumericT, typename DelayModelT>
+TradeOffTy bufferTradeOff(const RCGraphTy &G,
+                          const CandidatePolicyTy &candidates,
+                          EngineStatsTy *stats) {
+  using NetT = NetStateTy<NumericT, DelayModelT>;
+
+  auto &dag = acquireThreadDAG();
+  auto F = freeze(G);
+  NetT net{F, candidates, ApproximationTy{}};
+  LayeredFrontiersTy<NetT> frontiers{F};
+  ScratchTy<NetT> scratch;
+  for (auto node : F.getPostOrder())
+    solveLayeredNode(net, frontiers, node, dag, scratch);
+  return finalizeTradeOff(net, frontiers, dag, stats);
+}
+
+template <typename NumericT, typename DelayModelT>
+SolutionTy minimumBuffers(const RCGraphTy &G, NodeTy::FloatTy target,
+                          BufferCostKind cost,
+                          const CandidatePolicyTy &candidates,
+                          EngineStatsTy *stats) {
+  using NetT = NetStateTy<NumericT, DelayModelT>;
+
+  auto &dag = acquireThreadDAG();
+  auto F = freeze(G);
+  NetT net{F, candidates, ApproximationTy{}};
+  ScratchTy<NetT> scratch;
+  // Cheapest solution meeting the target so far and the figures of the pass
+  // that found it.
+  std::optional<TradeOffPointTy> found;
+  EngineStatsTy found_stats;
+  // Counting buffers, every pass is complete, but only the layers below the
+  // top one are exact. A solution found in them has the fewest buffers, one
+  // found in the top layer bounds the number of buffers for the next pass.
+  // Minimizing area, layers are told apart by area alone, so a single pass
+  // finds the least area without keeping a layer for every mix of buffers.
+  size_t max_layers = cost == BufferCostKind::Count
+                          ? 1
+                          : std::numeric_limits<size_t>::max();
+  while (true) {
+    dag.clear();
+    LayeredFrontiersTy<NetT> frontiers{F};
+    frontiers.CountBuffers = cost == BufferCostKind::Count;
+    frontiers.CountArea = cost == BufferCostKind::Area;
+    frontiers.MaxLayers = max_layers;
+    frontiers.Target = NumericT::fromReal(target);
+    for (auto node : F.getPostOrder())
+      solveLayeredNode(net, frontiers, node, dag, scratch);
+
+    EngineStatsTy pass_stats;
+    auto points = finalizeTradeOff(net, frontiers, dag, &pass_stats);
+    // Points come by decreasing RAT, so of equal cost the first one wins.
+    auto best = points.end();
+    for (auto it = points.begin(); it != points.end(); ++it) {
+      if (it->RAT < target)
+        continue;
+      if (best == points.end() ||
+          (cost == BufferCostKind::Count ? it->Buffers < best->Buffers
+                                         : it->Area < best->Area))
+        best = it;
+    }
+    if (best != points.end() && (!found || best->Buffers < found->Buffers)) {
+      found = std::move(*best);
+      found_stats = pass_stats;
+    }
+    if (!found || cost == BufferCostKind::Area ||
+        found->Buffers + 1 <= max_layers)
+      break;
+    max_layers = std::min(max_layers * 4, size_t{found->Buffers} + 1);
+  }
+
+  if (!found)
+    // Nothing meets the target, so nothing beats the best RAT.
+    return bufferInsertion<NumericT, DelayModelT>(G, candidates, {}, stats);
+  if (stats)
+    *stats = found_stats;
+  return std::move(found->Solution);
+}
+
+template <typename NumericT, typename DelayModelT>
+struct IncrementalBufferInsertion<NumericT, DelayModelT>::ImplTy {
+  using NetT = NetStateTy<NumericT, DelayModelT>;
+
+  // Records are never freed one by one, so once the DAG outgrows the one of
+  // the last full solve this many times the net is solved from scratch.
+  static constexpr size_t CompactionFactor = 4;
+
+  RCGraphTy &G;
+  FrozenRCGraph F;
+  NetT Net;
+  CandidateDAG DAG;
+  std::vector<bool> Dirty;
+  size_t NumDirty;
+  size_t FullSolveRecords = 0;
+
+  ImplTy(RCGraphTy &g, const CandidatePolicyTy &candidates,
+         const ApproximationTy &approximation)
+      : G{g}, F{g}, Net{F, candidates, approximation, /*keep_frontiers=*/true},
+        Dirty(F.getNodeIdBound()) {
+    markAll();
+  }
+
+  void markAll() {
+    for (auto node : F.getPostOrder())
+      Dirty[node] = true;
+    NumDirty = F.getNumNodes();
+  }
+
+  // Ancestors of a dirty node are dirty as well, so the walk stops at the
+  // first one.
+  void mark(NodeTy::NodeIdTy node) {
+    while (!Dirty[node]) {
+      Dirty[node] = true;
+      ++NumDirty;
+      if (node == F.getRoot())
+        break;
+      node = F.getParentNode(node);
+    }
+  }
+};
+
+template <typename NumericT, typename DelayModelT>
+IncrementalBufferInsertion<NumericT, DelayModelT>::IncrementalBufferInsertion(
+    RCGraphTy &G, const CandidatePolicyTy &candidates,
+    const ApproximationTy &approximation)
+    : Impl{std::make_unique<ImplTy>(G, candidates, approximation)} {}
+
+template <typename NumericT, typename DelayModelT>
+IncrementalBufferInsertion<NumericT,
+                           DelayModelT>::~IncrementalBufferInsertion() =
+    default;
+
+template <typename NumericT, typename DelayModelT>
+void IncrementalBufferInsertion<NumericT, DelayModelT>::setSink(
+    NodeTy::NodeIdTy node, NodeTy::FloatTy capacity, NodeTy::FloatTy rat) {
+  auto &sink = Impl->G.getNode(node);
+  if (sink.Kind != NodeKindTy::Point)
+    throw std::runtime_error("node " + sink.Name + " is not a sink");
+  sink.Capacity = capacity;
+  sink.RAT = rat;
+  Impl->mark(node);
+}
+
+template <typename NumericT, typename DelayModelT>
+void IncrementalBufferInsertion<NumericT, DelayModelT>::setEdgePoints(
+    EdgeTy::EdgeIdTy edge, PointsTy points) {
+  auto &G = Impl->G;
+  if (points.empty() ||
+      !(points.front() == G.getNode(G.getEdgeNodeFirst(edge)).P) ||
+      !(points.back() == G.getNode(G.getEdgeNodeLast(edge)).P))
+    throw std::runtime_error("edge points must run between its nodes");
+  G.getEdge(edge).Ps = std::move(points);
+  Impl->F.updatePoints(edge);
+  Impl->mark(G.getEdgeNodeLast(edge));
+}
+
+template <typename NumericT, typename DelayModelT>
+void IncrementalBufferInsertion<NumericT, DelayModelT>::markModified(
+    NodeTy::NodeIdTy node) {
+  Impl->mark(node);
+}
+
+template <typename NumericT, typename DelayModelT>
+SolutionTy
+IncrementalBufferInsertion<NumericT, DelayModelT>::solve(EngineStatsTy *stats) {
+  auto &impl = *Impl;
+  if (impl.DAG.size() >
+      ImplTy::CompactionFactor * std::max<size_t>(impl.FullSolveRecords, 1024)) {
+    impl.DAG.clear();
+    impl.markAll();
+  }
+
+  bool full = impl.NumDirty == impl.F.getNumNodes();
+  auto records = impl.DAG.size();
+  ScratchTy<typename ImplTy::NetT> scratch;
+  for (auto node : impl.F.getPostOrder()) {
+    if (!impl.Dirty[node])
+      continue;
+    solveNode(impl.Net, node, impl.DAG, scratch);
+    impl.Dirty[node] = false;
+  }
+  impl.NumDirty = 0;
+  // Records of earlier solves stay in the DAG, only the ones of this solve
+  // count.
+  if (full)
+    impl.FullSolveRecords = impl.DAG.size() - records;
+
+  return finalize(impl.Net, {&impl.DAG, 1}, stats);
+}
+
+#define INSTANTIATE_BUFFER_INSERTION(NumericT, DelayModelT)                    \
+  template SolutionTy bufferInsertion<NumericT, DelayModelT>(                  \
+      const RCGraphTy &, const CandidatePolicyTy &, const ApproximationTy &,   \
+      EngineStatsTy *, SubtreeCache *);                                        \
+  template SolutionTy bufferInsertion<NumericT, DelayModelT>(                  \
+      const RCGraphTy &, ThreadPool &, unsigned, const CandidatePolicyTy &,    \
+      const ApproximationTy &, EngineStatsTy *, SubtreeCache *);               \
+  template TradeOffTy bufferTradeOff<NumericT, DelayModelT>(                   \
+      const RCGraphTy &, const CandidatePolicyTy &, EngineStatsTy *);          \
+  template SolutionTy minimumBuffers<NumericT, DelayModelT>(                   \
+      const RCGraphTy &, NodeTy::FloatTy, BufferCostKind,                      \
+      const CandidatePolicyTy &, EngineStatsTy *);                             \
+  template class IncrementalBufferInsertion<NumericT, DelayModelT>;
+
+INSTANTIATE_BUFFER_INSERTION(SingleNumeric, ElmoreDelay)
+INSTANTIATE_BUFFER_INSERTION(SingleNumeric, LumpedDelay)
+INSTANTIATE_BUFFER_INSERTION(DoubleNumeric, ElmoreDelay)
+INSTANTIATE_BUFFER_INSERTION(DoubleNumeric, LumpedDelay)
+INSTANTIATE_BUFFER_INSERTION(FixedNumeric, ElmoreDelay)
+INSTANTIATE_BUFFER_INSERTION(FixedNumeric, LumpedDelay)
+
+#undef INSTANTIATE_BUFFER_INSERTION
+
 } // namespace algo
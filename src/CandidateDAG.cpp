@@ -0,0 +1,89 @@
+#include "CandidateDAG.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace algo {
+
+CandidateDAG &acquireThreadDAG() {
+  thread_local CandidateDAG DAG;
+  DAG.clear();
+  return DAG;
+}
+
+SolutionTy collectBuffers(const CandidateRecordTy *Record) {
+  SolutionTy Solution;
+  std::vector<std::pair<const CandidateRecordTy *, bool>> Stack;
+  if (Record)
+    Stack.emplace_back(Record, false);
+  while (!Stack.empty()) {
+    auto [Top, Expanded] = Stack.back();
+    Stack.pop_back();
+    if (Expanded) {
+      Solution.emplace_back(Top->Capacity, Top->RAT, Top->P, Top->EId,
+                            /*HasBuffer=*/true, Top->Buffer);
+      continue;
+    }
+    if (Top->Kind == CandidateRecordTy::KindTy::Buffer)
+      Stack.emplace_back(Top, true);
+    if (Top->Rhs)
+      Stack.emplace_back(Top->Rhs, false);
+    if (Top->Lhs)
+      Stack.emplace_back(Top->Lhs, false);
+  }
+  return Solution;
+}
+
+SolutionTy collectSolution(const FrontierEntryTy &Best, PointTy Root) {
+  SolutionTy Solution = collectBuffers(Best.Record);
+  Solution.emplace_back(Best.Capacity, Best.RAT, Root,
+                        RCGraphTy::invalidEdgeId(), /*HasBuffer=*/false);
+  return Solution;
+}
+
+void buildHull(const FrontierTy &Frontier, HullTy &Hull) {
+  assert(std::is_sorted(Frontier.begin(), Frontier.end(), byCapacity));
+  Hull.clear();
+  for (size_t Idx = 0; Idx != Frontier.size(); ++Idx) {
+    while (Hull.size() > 1 && cross(Frontier[Hull[Hull.size() - 2]],
+                                    Frontier[Hull.back()], Frontier[Idx]) >= 0)
+      Hull.pop_back();
+    Hull.push_back(Idx);
+  }
+}
+
+// Each step combines the current pair and advances the side with the smaller
+// RAT: advancing the other side would only add capacity without improving the
+// minimum. So only non-dominated combinations are emitted.
+FrontierTy mergeFrontiers(const FrontierTy &Lhs, const FrontierTy &Rhs,
+                          CandidateDAG &DAG) {
+  assert(std::is_sorted(Lhs.begin(), Lhs.end(), byCapacity));
+  assert(std::is_sorted(Rhs.begin(), Rhs.end(), byCapacity));
+
+  FrontierTy Merged;
+  Merged.reserve(Lhs.size() + Rhs.size());
+
+  auto LhsIt = Lhs.begin();
+  auto RhsIt = Rhs.begin();
+  while (LhsIt != Lhs.end() && RhsIt != Rhs.end()) {
+    auto Capacity = LhsIt->Capacity + RhsIt->Capacity;
+    auto RAT = std::min(LhsIt->RAT, RhsIt->RAT);
+    // Rounding may collapse two sums into one capacity.
+    if (!Merged.empty() && Merged.back().Capacity >= Capacity)
+      Merged.pop_back();
+    Merged.push_back({Capacity, RAT, DAG.join(LhsIt->Record, RhsIt->Record)});
+
+    if (LhsIt->RAT < RhsIt->RAT) {
+      ++LhsIt;
+    } else if (RhsIt->RAT < LhsIt->RAT) {
+      ++RhsIt;
+    } else {
+      ++LhsIt;
+      ++RhsIt;
+    }
+  }
+  return Merged;
+}
+
+} // namespace algo
@@ -11,32 +11,35 @@ Config readConfig(std::istream &Is) {
   assert(DataObj.contains("module"));
   auto ModuleArr = DataObj["module"];
   assert(ModuleArr.is_array());
-  assert(ModuleArr.size() == 1);
-  auto ModuleObj = ModuleArr.at(0);
-  assert(ModuleObj.is_object());
-  assert(ModuleObj.contains("name"));
-  auto Kind = ModuleKind::Buffer;
-  auto NameStr = ModuleObj["name"];
-  assert(ModuleObj.contains("input"));
-  auto InputArr = ModuleObj["input"];
-  assert(InputArr.is_array());
-  assert(InputArr.size() == 1);
-  auto InputObj = InputArr.at(0);
-  assert(InputObj.is_object());
-  assert(InputObj.contains("C"));
-  auto CFloat = InputObj["C"];
-  assert(InputObj.contains("R"));
-  auto RFloat = InputObj["R"];
-  assert(InputObj.contains("intrinsic_delay"));
-  auto KFloat = InputObj["intrinsic_delay"];
-  auto Mod = Module{
-      .Kind = Kind,
-      .Name = NameStr.template get<std::string>(),
-      .R = RFloat.template get<Module::FloatTy>(),
-      .C = CFloat.template get<Module::FloatTy>(),
-      .K = KFloat.template get<Module::FloatTy>(),
-  };
-  Cfg.addModule(Kind, std::move(Mod));
+  assert(ModuleArr.size() > 0);
+  for (auto &&ModuleObj : ModuleArr) {
+    assert(ModuleObj.is_object());
+    assert(ModuleObj.contains("name"));
+    auto Kind = ModuleKind::Buffer;
+    auto NameStr = ModuleObj["name"];
+    assert(ModuleObj.contains("input"));
+    auto InputArr = ModuleObj["input"];
+    assert(InputArr.is_array());
+    assert(InputArr.size() == 1);
+    auto InputObj = InputArr.at(0);
+    assert(InputObj.is_object());
+    assert(InputObj.contains("C"));
+    auto CFloat = InputObj["C"];
+    assert(InputObj.contains("R"));
+    auto RFloat = InputObj["R"];
+    assert(InputObj.contains("intrinsic_delay"));
+    auto KFloat = InputObj["intrinsic_delay"];
+    auto Mod = Module{
+        .Kind = Kind,
+        .Name = NameStr.template get<std::string>(),
+        .R = RFloat.template get<Module::FloatTy>(),
+        .C = CFloat.template get<Module::FloatTy>(),
+        .K = KFloat.template get<Module::FloatTy>(),
+    };
+    if (ModuleObj.contains("area"))
+      Mod.Area = ModuleObj["area"].template get<Module::FloatTy>();
+    Cfg.addModule(Kind, std::move(Mod));
+  }
   assert(DataObj.contains("technology"));
   auto TechObj = DataObj["technology"];
   assert(TechObj.is_object());
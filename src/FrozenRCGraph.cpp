@@ -0,0 +1,104 @@
+#include "FrozenRCGraph.h"
+
+#include <algorithm>
+#include <ranges>
+
+namespace algo {
+
+FrozenRCGraph::FrozenRCGraph(const RCGraphTy &Graph)
+    : G{&Graph}, ChildBegin(Graph.getNodeIdBound() + 1),
+      Parents(Graph.getNodeIdBound(), RCGraphTy::invalidEdgeId()),
+      ParentNodes(Graph.getNodeIdBound(), RCGraphTy::invalidNodeId()),
+      PostIndex(Graph.getNodeIdBound()), SubtreeSize(Graph.getNodeIdBound()) {
+  EdgeIdTy EdgeIdBound = 0;
+
+  // One walk gives both orders: rows of child edges are indexed by node id,
+  // points are laid out in pre-order so that a subtree's edges stay close.
+  std::vector<std::pair<NodeIdTy, unsigned>> Stack{{Graph.getRoot(), 0}};
+  std::vector<NodeIdTy> PreOrder;
+  while (!Stack.empty()) {
+    auto &[NId, Next] = Stack.back();
+    if (Next == 0)
+      PreOrder.push_back(NId);
+    const auto &Children = Graph.getChildren(NId);
+    if (Next != Children.size()) {
+      auto EId = Children[Next++];
+      EdgeIdBound = std::max(EdgeIdBound, EId + 1);
+      Stack.emplace_back(Graph.getEdgeNodeLast(EId), 0);
+      continue;
+    }
+    PostIndex[NId] = PostOrder.size();
+    SubtreeSize[NId] = 1;
+    for (auto EId : Children)
+      SubtreeSize[NId] += SubtreeSize[Graph.getEdgeNodeLast(EId)];
+    PostOrder.push_back(NId);
+    Stack.pop_back();
+  }
+
+  PointBegin.resize(EdgeIdBound);
+  PointEnd.resize(EdgeIdBound);
+  PointCapacity.resize(EdgeIdBound);
+  std::vector<unsigned> RowSize(Graph.getNodeIdBound());
+  for (auto NId : PreOrder)
+    RowSize[NId] = Graph.getChildren(NId).size();
+  for (NodeIdTy NId = 0; NId != Graph.getNodeIdBound(); ++NId)
+    ChildBegin[NId + 1] = ChildBegin[NId] + RowSize[NId];
+
+  ChildEdges.resize(ChildBegin.back());
+  ChildNodes.resize(ChildBegin.back());
+  for (auto NId : PreOrder) {
+    auto Pos = ChildBegin[NId];
+    for (auto EId : Graph.getChildren(NId)) {
+      auto Last = Graph.getEdgeNodeLast(EId);
+      ChildEdges[Pos] = EId;
+      ChildNodes[Pos] = Last;
+      ++Pos;
+      Parents[Last] = EId;
+      ParentNodes[Last] = NId;
+
+      const auto &Ps = Graph.getEdge(EId).Ps;
+      PointBegin[EId] = Points.size();
+      Points.insert(Points.end(), Ps.begin(), Ps.end());
+      PointEnd[EId] = Points.size();
+      PointCapacity[EId] = Ps.size();
+    }
+  }
+}
+
+void FrozenRCGraph::updatePoints(EdgeIdTy EId) {
+  const auto &Ps = G->getEdge(EId).Ps;
+  if (Ps.size() > PointCapacity[EId]) {
+    UnusedPoints += PointCapacity[EId];
+    PointCapacity[EId] = std::max<size_t>(Ps.size(), 2 * PointCapacity[EId]);
+    // The slot is filled with copies of the last point up to its capacity.
+    PointBegin[EId] = Points.size();
+    Points.insert(Points.end(), Ps.begin(), Ps.end());
+    Points.insert(Points.end(), PointCapacity[EId] - Ps.size(), Ps.back());
+    PointEnd[EId] = PointBegin[EId] + Ps.size();
+    if (2 * UnusedPoints > Points.size())
+      repackPoints();
+    return;
+  }
+  std::copy(Ps.begin(), Ps.end(), Points.begin() + PointBegin[EId]);
+  PointEnd[EId] = PointBegin[EId] + Ps.size();
+}
+
+void FrozenRCGraph::repackPoints() {
+  PointsTy Packed;
+  Packed.reserve(Points.size() - UnusedPoints);
+  // Parents come before their children, as in the first layout.
+  for (auto NId : std::views::reverse(PostOrder)) {
+    if (NId == getRoot())
+      continue;
+    auto EId = Parents[NId];
+    auto Begin = Points.begin() + PointBegin[EId];
+    auto Size = PointEnd[EId] - PointBegin[EId];
+    PointBegin[EId] = Packed.size();
+    PointEnd[EId] = PointBegin[EId] + Size;
+    Packed.insert(Packed.end(), Begin, Begin + PointCapacity[EId]);
+  }
+  Points = std::move(Packed);
+  UnusedPoints = 0;
+}
+
+} // namespace algo
@@ -1,6 +1,11 @@
 #include "RCGraph.h"
 #include "JSON.h"
+#include <charconv>
+#include <cmath>
+#include <iterator>
+#include <optional>
 #include <string_view>
+#include <type_traits>
 #include <unordered_map>
 
 namespace algo {
@@ -35,91 +40,314 @@ using EdgeIdTy = RCGraphTy::EdgeIdTy;
 using CoordTy = PointTy::CoordTy;
 using FloatTy = NodeTy::FloatTy;
 
-RCGraphTy readRCGraph(std::istream &IS) {
+namespace {
+
+// Builds the graph straight from parser events, so no DOM of the whole file
+// is ever kept. Fields of a node or an edge may come in any order, edges are
+// added once the whole file is read as they may precede their nodes.
+class RCGraphReader final : public nlohmann::json_sax<nlohmann::json> {
+  enum class StateTy {
+    Document,
+    Top,
+    Nodes,
+    Node,
+    Edges,
+    Edge,
+    Vertices,
+    Segments,
+    Segment,
+    Skip,
+  };
+
+  enum class FieldTy {
+    Unknown,
+    Nodes,
+    Edges,
+    Id,
+    X,
+    Y,
+    Type,
+    Name,
+    Capacity,
+    RAT,
+    Vertices,
+    Segments,
+  };
+
+  struct NodeEntryTy {
+    std::optional<int> Id;
+    std::optional<CoordTy> X;
+    std::optional<CoordTy> Y;
+    std::optional<NodeKindTy> Kind;
+    std::optional<std::string> Name;
+    FloatTy Capacity = FloatTy{};
+    FloatTy RAT = FloatTy{};
+  };
+
+  struct EdgeEntryTy {
+    std::vector<int> Vertices;
+    PointsTy Ps;
+  };
+
+  std::vector<StateTy> States{StateTy::Document};
+  FieldTy Field = FieldTy::Unknown;
+
+  NodeEntryTy Node;
+  EdgeEntryTy Edge;
+  std::vector<CoordTy> Segment;
+  std::vector<EdgeEntryTy> Edges;
+
   RCGraphTy G;
   std::unordered_map<int, NodeIdTy> NodeMapping;
-  std::unordered_map<int, EdgeIdTy> EdgeMapping;
-  auto DataObj = nlohmann::json{};
-  IS >> DataObj;
-  assert(DataObj.is_object());
-  assert(DataObj.contains("node"));
-  auto NodeArr = DataObj["node"];
-  assert(NodeArr.is_array());
-  for (auto &&NodeObj : NodeArr) {
-    assert(NodeObj.is_object());
-    assert(NodeObj.contains("id"));
-    auto NodeId = NodeObj["id"];
-    assert(NodeObj.contains("x"));
-    auto NodeX = NodeObj["x"];
-    assert(NodeObj.contains("y"));
-    auto NodeY = NodeObj["y"];
-    assert(NodeObj.contains("type"));
-    auto NodeTypeStr = NodeObj["type"];
-    auto NodeTypeAsStr = NodeTypeStr.template get<std::string>();
-    auto NodeKind = fromString(NodeTypeAsStr);
-    assert(NodeObj.contains("name"));
-    auto NodeName = NodeObj["name"];
-    auto NodeCapacityFloat = FloatTy{};
-    if (NodeObj.contains("capacitance")) {
-      auto NodeCapacity = NodeObj["capacitance"];
-      NodeCapacityFloat = NodeCapacity.template get<FloatTy>();
+
+  template <typename To, typename From> static To toNumber(From &Val) {
+    if constexpr (std::is_arithmetic_v<From> && !std::is_same_v<From, bool>)
+      return static_cast<To>(Val);
+    else
+      throw std::runtime_error("number expected");
+  }
+
+  template <typename From> static std::string toString(From &Val) {
+    if constexpr (std::is_same_v<From, string_t>)
+      return std::move(Val);
+    else
+      throw std::runtime_error("string expected");
+  }
+
+  template <typename T> bool scalar(T &Val) {
+    switch (States.back()) {
+    case StateTy::Node:
+      setNodeField(Val);
+      return true;
+    case StateTy::Vertices:
+      Edge.Vertices.push_back(toNumber<int>(Val));
+      return true;
+    case StateTy::Segment:
+      Segment.push_back(toNumber<CoordTy>(Val));
+      return true;
+    case StateTy::Top:
+    case StateTy::Edge:
+      if (Field != FieldTy::Unknown)
+        throw std::runtime_error("array expected");
+      return true;
+    case StateTy::Skip:
+      return true;
+    default:
+      throw std::runtime_error("unexpected value");
     }
-    auto NodeRATFloat = FloatTy{};
-    if (NodeObj.contains("rat")) {
-      auto NodeRAT = NodeObj["rat"];
-      NodeRATFloat = NodeRAT.template get<FloatTy>();
+  }
+
+  template <typename T> void setNodeField(T &Val) {
+    switch (Field) {
+    case FieldTy::Id:
+      Node.Id = toNumber<int>(Val);
+      break;
+    case FieldTy::X:
+      Node.X = toNumber<CoordTy>(Val);
+      break;
+    case FieldTy::Y:
+      Node.Y = toNumber<CoordTy>(Val);
+      break;
+    case FieldTy::Type:
+      Node.Kind = fromString(toString(Val));
+      break;
+    case FieldTy::Name:
+      Node.Name = toString(Val);
+      break;
+    case FieldTy::Capacity:
+      Node.Capacity = toNumber<FloatTy>(Val);
+      break;
+    case FieldTy::RAT:
+      Node.RAT = toNumber<FloatTy>(Val);
+      break;
+    default:
+      break;
     }
-    auto Point = PointTy{
-        NodeX.template get<CoordTy>(),
-        NodeY.template get<CoordTy>(),
-    };
-    auto Node = NodeTy{
-        .Kind = NodeKind,
-        .Name = NodeName.template get<std::string>(),
-        .P = std::move(Point),
-        .Capacity = NodeCapacityFloat,
-        .RAT = NodeRATFloat,
-    };
-    auto NId = G.addNode(std::move(Node));
-    if (NodeKind == NodeKindTy::Buffer) {
+  }
+
+  // Values of unknown fields are skipped, known fields must not be
+  // containers unless the state machine expects one.
+  void enterUnknown() {
+    bool InObject = States.back() == StateTy::Top ||
+                    States.back() == StateTy::Node ||
+                    States.back() == StateTy::Edge;
+    if (States.back() != StateTy::Skip &&
+        (!InObject || Field != FieldTy::Unknown))
+      throw std::runtime_error("unexpected container");
+    States.push_back(StateTy::Skip);
+  }
+
+  void finishNode() {
+    if (!Node.Id || !Node.X || !Node.Y || !Node.Kind || !Node.Name)
+      throw std::runtime_error("node requires id, x, y, type and name");
+    auto NId = G.addNode(NodeTy{
+        .Kind = *Node.Kind,
+        .Name = std::move(*Node.Name),
+        .P = PointTy{*Node.X, *Node.Y},
+        .Capacity = Node.Capacity,
+        .RAT = Node.RAT,
+    });
+    if (*Node.Kind == NodeKindTy::Buffer) {
       G.setRoot(NId);
     }
-    NodeMapping.emplace(NodeId, NId);
-  }
-  assert(DataObj.contains("edge"));
-  auto EdgeArr = DataObj["edge"];
-  assert(EdgeArr.is_array());
-  for (auto &&EdgeObj : EdgeArr) {
-    assert(EdgeObj.is_object());
-    assert(EdgeObj.contains("vertices"));
-    auto EdgeVerticesArr = EdgeObj["vertices"];
-    assert(EdgeVerticesArr.is_array());
-    assert(EdgeVerticesArr.size() == 2);
-    auto FirstIdStr = EdgeVerticesArr[0];
-    auto FirstIdInt = FirstIdStr.template get<int>();
-    auto FirstId = NodeMapping[FirstIdInt];
-    auto LastIdStr = EdgeVerticesArr[1];
-    auto LastIdInt = LastIdStr.template get<int>();
-    auto LastId = NodeMapping[LastIdInt];
-    assert(EdgeObj.contains("segments"));
-    auto EdgeSegmentsArr = EdgeObj["segments"];
-    assert(EdgeSegmentsArr.is_array());
-    auto Points = PointsTy{};
-    for (auto &&EdgeSegmentArr : EdgeSegmentsArr) {
-      assert(EdgeSegmentArr.is_array());
-      assert(EdgeSegmentArr.size() == 2);
-      auto XStr = EdgeSegmentArr[0];
-      auto YStr = EdgeSegmentArr[1];
-      auto Point = PointTy{
-          XStr.template get<CoordTy>(),
-          YStr.template get<CoordTy>(),
-      };
-      Points.push_back(std::move(Point));
+    if (!NodeMapping.emplace(*Node.Id, NId).second)
+      throw std::runtime_error("duplicate node id " + std::to_string(*Node.Id));
+  }
+
+  void finishEdge() {
+    if (Edge.Vertices.size() != 2)
+      throw std::runtime_error("edge requires two vertices");
+    Edges.push_back(std::move(Edge));
+  }
+
+  NodeIdTy getNodeId(int Id) const {
+    auto Found = NodeMapping.find(Id);
+    if (Found == NodeMapping.end())
+      throw std::runtime_error("edge to unknown node " + std::to_string(Id));
+    return Found->second;
+  }
+
+public:
+  bool null() override {
+    std::nullptr_t Val = nullptr;
+    return scalar(Val);
+  }
+
+  bool boolean(bool Val) override { return scalar(Val); }
+
+  bool number_integer(number_integer_t Val) override { return scalar(Val); }
+
+  bool number_unsigned(number_unsigned_t Val) override { return scalar(Val); }
+
+  bool number_float(number_float_t Val, const string_t &) override {
+    return scalar(Val);
+  }
+
+  bool string(string_t &Val) override { return scalar(Val); }
+
+  bool binary(binary_t &) override {
+    throw std::runtime_error("unexpected binary value");
+  }
+
+  bool start_object(std::size_t) override {
+    switch (States.back()) {
+    case StateTy::Document:
+      States.push_back(StateTy::Top);
+      break;
+    case StateTy::Nodes:
+      Node = NodeEntryTy{};
+      States.push_back(StateTy::Node);
+      break;
+    case StateTy::Edges:
+      Edge = EdgeEntryTy{};
+      States.push_back(StateTy::Edge);
+      break;
+    default:
+      enterUnknown();
+      break;
+    }
+    return true;
+  }
+
+  bool key(string_t &Key) override {
+    Field = FieldTy::Unknown;
+    switch (States.back()) {
+    case StateTy::Top:
+      if (Key == "node")
+        Field = FieldTy::Nodes;
+      else if (Key == "edge")
+        Field = FieldTy::Edges;
+      break;
+    case StateTy::Node:
+      if (Key == "id")
+        Field = FieldTy::Id;
+      else if (Key == "x")
+        Field = FieldTy::X;
+      else if (Key == "y")
+        Field = FieldTy::Y;
+      else if (Key == "type")
+        Field = FieldTy::Type;
+      else if (Key == "name")
+        Field = FieldTy::Name;
+      else if (Key == "capacitance")
+        Field = FieldTy::Capacity;
+      else if (Key == "rat")
+        Field = FieldTy::RAT;
+      break;
+    case StateTy::Edge:
+      if (Key == "vertices")
+        Field = FieldTy::Vertices;
+      else if (Key == "segments")
+        Field = FieldTy::Segments;
+      break;
+    default:
+      break;
     }
-    auto Edge = EdgeTy{.Ps = std::move(Points)};
-    G.addEdge(FirstId, LastId, std::move(Edge));
+    return true;
+  }
+
+  bool end_object() override {
+    auto State = States.back();
+    States.pop_back();
+    if (State == StateTy::Node)
+      finishNode();
+    else if (State == StateTy::Edge)
+      finishEdge();
+    return true;
+  }
+
+  bool start_array(std::size_t) override {
+    auto State = States.back();
+    if (State == StateTy::Top && Field == FieldTy::Nodes) {
+      States.push_back(StateTy::Nodes);
+    } else if (State == StateTy::Top && Field == FieldTy::Edges) {
+      States.push_back(StateTy::Edges);
+    } else if (State == StateTy::Edge && Field == FieldTy::Vertices) {
+      Edge.Vertices.clear();
+      States.push_back(StateTy::Vertices);
+    } else if (State == StateTy::Edge && Field == FieldTy::Segments) {
+      Edge.Ps.clear();
+      States.push_back(StateTy::Segments);
+    } else if (State == StateTy::Segments) {
+      Segment.clear();
+      States.push_back(StateTy::Segment);
+    } else {
+      enterUnknown();
+    }
+    return true;
+  }
+
+  bool end_array() override {
+    auto State = States.back();
+    States.pop_back();
+    if (State == StateTy::Segment) {
+      if (Segment.size() != 2)
+        throw std::runtime_error("segment point requires two coordinates");
+      Edge.Ps.emplace_back(Segment[0], Segment[1]);
+    }
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string &,
+                   const nlohmann::detail::exception &E) override {
+    throw std::runtime_error(E.what());
   }
-  return G;
+
+  RCGraphTy finish() {
+    for (auto &&E : Edges)
+      G.addEdge(getNodeId(E.Vertices[0]), getNodeId(E.Vertices[1]),
+                EdgeTy{.Ps = std::move(E.Ps)});
+    Edges.clear();
+    return std::move(G);
+  }
+};
+
+} // namespace
+
+RCGraphTy readRCGraph(std::istream &IS) {
+  RCGraphReader Reader;
+  nlohmann::json::sax_parse(IS, &Reader);
+  return Reader.finish();
 }
 
 static void collect(const RCGraphTy &G, std::vector<NodeIdTy> &NIds,
@@ -181,47 +409,215 @@ void dumpDot(const RCGraphTy &G, std::ostream &OS) {
   OS << "}" << std::endl;
 }
 
-void writeRCGraph(const RCGraphTy &G, std::ostream &OS) {
+namespace {
+
+// Writes JSON in one pass through a buffer that is flushed to the stream in
+// large chunks. The layout matches nlohmann::json::dump for the same
+// document: with Indent == 0 nothing but the values is written, otherwise
+// every value starts on its own line.
+class JSONWriter final {
+  static constexpr size_t FlushSize = 1 << 16;
+
+  std::ostream &OS;
+  unsigned Indent;
+  std::string Buffer;
+  // Whether the innermost open container has any values yet.
+  std::vector<bool> NonEmpty;
+  bool AfterKey = false;
+
+  void flushIfFull() {
+    if (Buffer.size() >= FlushSize)
+      flush();
+  }
+
+  void newLine() {
+    Buffer += '\n';
+    Buffer.append(NonEmpty.size() * Indent, ' ');
+  }
+
+  void beginValue() {
+    if (AfterKey) {
+      AfterKey = false;
+      return;
+    }
+    if (NonEmpty.empty())
+      return;
+    if (NonEmpty.back())
+      Buffer += ',';
+    NonEmpty.back() = true;
+    if (Indent)
+      newLine();
+  }
+
+  void open(char Bracket) {
+    beginValue();
+    Buffer += Bracket;
+    NonEmpty.push_back(false);
+  }
+
+  void close(char Bracket) {
+    bool HadValues = NonEmpty.back();
+    NonEmpty.pop_back();
+    if (Indent && HadValues)
+      newLine();
+    Buffer += Bracket;
+    flushIfFull();
+  }
+
+  void writeString(std::string_view S) {
+    static constexpr char Hex[] = "0123456789abcdef";
+    Buffer += '"';
+    for (char C : S) {
+      switch (C) {
+      case '"':
+        Buffer += "\\\"";
+        break;
+      case '\\':
+        Buffer += "\\\\";
+        break;
+      case '\b':
+        Buffer += "\\b";
+        break;
+      case '\f':
+        Buffer += "\\f";
+        break;
+      case '\n':
+        Buffer += "\\n";
+        break;
+      case '\r':
+        Buffer += "\\r";
+        break;
+      case '\t':
+        Buffer += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(C) < 0x20) {
+          Buffer += "\\u00";
+          Buffer += Hex[C >> 4];
+          Buffer += Hex[C & 0xf];
+        } else {
+          Buffer += C;
+        }
+        break;
+      }
+    }
+    Buffer += '"';
+  }
+
+public:
+  JSONWriter(std::ostream &OS, unsigned Indent) : OS{OS}, Indent{Indent} {
+    Buffer.reserve(FlushSize + FlushSize / 2);
+  }
+
+  ~JSONWriter() { flush(); }
+
+  JSONWriter(const JSONWriter &) = delete;
+  JSONWriter &operator=(const JSONWriter &) = delete;
+
+  void flush() {
+    OS.write(Buffer.data(), Buffer.size());
+    Buffer.clear();
+  }
+
+  void beginObject() { open('{'); }
+  void endObject() { close('}'); }
+  void beginArray() { open('['); }
+  void endArray() { close(']'); }
+
+  void key(std::string_view Key) {
+    beginValue();
+    writeString(Key);
+    Buffer += Indent ? ": " : ":";
+    AfterKey = true;
+  }
+
+  void value(std::string_view S) {
+    beginValue();
+    writeString(S);
+  }
+
+  template <typename T>
+  requires std::is_integral_v<T> void value(T Val) {
+    beginValue();
+    char Chars[24];
+    auto *End = std::to_chars(std::begin(Chars), std::end(Chars), Val).ptr;
+    Buffer.append(Chars, End);
+  }
+
+  void value(double Val) {
+    beginValue();
+    if (!std::isfinite(Val)) {
+      Buffer += "null";
+      return;
+    }
+    char Chars[64];
+    auto *End = nlohmann::detail::to_chars(std::begin(Chars), std::end(Chars),
+                                           Val);
+    Buffer.append(Chars, End);
+  }
+};
+
+} // namespace
+
+void writeRCGraph(const RCGraphTy &G, std::ostream &OS, unsigned Indent) {
   std::vector<NodeIdTy> NIds;
   std::vector<EdgeIdTy> EIds;
   collect(G, NIds, EIds);
-  auto DataObj = nlohmann::json{};
-  auto &NodesArr = DataObj["node"];
-  for (NodeIdTy NId : NIds) {
-    const NodeTy &Node = G.getNode(NId);
-    auto NodeObj = nlohmann::json{};
-    NodeObj["id"] = NId;
-    NodeObj["x"] = Node.P.X;
-    NodeObj["y"] = Node.P.Y;
-    NodeObj["type"] = toString(Node.Kind);
-    NodeObj["name"] = Node.Name;
-    if (Node.Kind == NodeKindTy::Point) {
-      NodeObj["capacitance"] = Node.Capacity;
-      NodeObj["rat"] = Node.RAT;
-    }
-    NodesArr.push_back(std::move(NodeObj));
-  }
-  auto &EdgesArr = DataObj["edge"];
+
+  // Keys are written in lexicographic order, as nlohmann::json keeps them.
+  JSONWriter W{OS, Indent};
+  W.beginObject();
+  W.key("edge");
+  W.beginArray();
   for (EdgeIdTy EId : EIds) {
     const EdgeTy &Edge = G.getEdge(EId);
-    NodeIdTy First = G.getEdgeNodeFirst(EId);
-    NodeIdTy Last = G.getEdgeNodeLast(EId);
-    auto EdgeObj = nlohmann::json{};
-    EdgeObj["id"] = EId;
-    auto EdgeVerticesArr = nlohmann::json{};
-    EdgeVerticesArr.push_back(First);
-    EdgeVerticesArr.push_back(Last);
-    EdgeObj["vertices"] = std::move(EdgeVerticesArr);
-    auto EdgeSegmentsArr = nlohmann::json{};
+    W.beginObject();
+    W.key("id");
+    W.value(EId);
+    W.key("segments");
+    W.beginArray();
     for (auto &&P : Edge.Ps) {
-      auto EdgeSegmentArr = nlohmann::json{};
-      EdgeSegmentArr.push_back(P.X);
-      EdgeSegmentArr.push_back(P.Y);
-      EdgeSegmentsArr.push_back(std::move(EdgeSegmentArr));
+      W.beginArray();
+      W.value(P.X);
+      W.value(P.Y);
+      W.endArray();
+    }
+    W.endArray();
+    W.key("vertices");
+    W.beginArray();
+    W.value(G.getEdgeNodeFirst(EId));
+    W.value(G.getEdgeNodeLast(EId));
+    W.endArray();
+    W.endObject();
+  }
+  W.endArray();
+  W.key("node");
+  W.beginArray();
+  for (NodeIdTy NId : NIds) {
+    const NodeTy &Node = G.getNode(NId);
+    bool IsPoint = Node.Kind == NodeKindTy::Point;
+    W.beginObject();
+    if (IsPoint) {
+      W.key("capacitance");
+      W.value(double{Node.Capacity});
+    }
+    W.key("id");
+    W.value(NId);
+    W.key("name");
+    W.value(Node.Name);
+    if (IsPoint) {
+      W.key("rat");
+      W.value(double{Node.RAT});
     }
-    EdgeObj["segments"] = std::move(EdgeSegmentsArr);
-    EdgesArr.push_back(std::move(EdgeObj));
+    W.key("type");
+    W.value(toString(Node.Kind));
+    W.key("x");
+    W.value(Node.P.X);
+    W.key("y");
+    W.value(Node.P.Y);
+    W.endObject();
   }
-  OS << std::setw(4) << DataObj;
+  W.endArray();
+  W.endObject();
 }
 } // namespace algo
@@ -0,0 +1,318 @@
+#include "RCGraph.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ALGO_HAS_MMAP 1
+#else
+#define ALGO_HAS_MMAP 0
+#endif
+
+// Binary net layout, all integers little-endian:
+//
+//   HeaderTy
+//   BinaryNodeTy[NumNodes]    in the order of their ids
+//   BinaryEdgeTy[NumEdges]    in the order of their ids
+//   BinaryPointTy[NumPoints]  segment points of all edges back to back
+//   char[NumChars]            node names, not null-terminated
+//
+// Every table is 8-byte aligned, so a mapped file is read in place. Ids are
+// compacted on write, for a graph without removed nodes and edges they are
+// kept as they are, so a net solves the same in both formats.
+
+namespace algo {
+
+namespace {
+
+constexpr char Magic[8] = {'R', 'C', 'G', 'R', 'A', 'P', 'H', '\0'};
+constexpr uint32_t Version = 1;
+
+struct HeaderTy {
+  char Magic[8];
+  uint32_t Version;
+  uint32_t NumNodes;
+  uint32_t NumEdges;
+  uint32_t Root;
+  uint64_t NumPoints;
+  uint64_t NumChars;
+};
+
+struct BinaryNodeTy {
+  int32_t X;
+  int32_t Y;
+  float Capacity;
+  float RAT;
+  uint32_t NameBegin;
+  uint32_t NameSize;
+  uint32_t Kind;
+  uint32_t Reserved;
+};
+
+struct BinaryEdgeTy {
+  uint32_t First;
+  uint32_t Last;
+  uint64_t PointsBegin;
+  uint64_t NumPoints;
+};
+
+struct BinaryPointTy {
+  int32_t X;
+  int32_t Y;
+};
+
+static_assert(sizeof(HeaderTy) == 40);
+static_assert(sizeof(BinaryNodeTy) == 32);
+static_assert(sizeof(BinaryEdgeTy) == 24);
+static_assert(sizeof(BinaryPointTy) == 8);
+static_assert(sizeof(NodeTy::FloatTy) == sizeof(float));
+static_assert(sizeof(PointTy::CoordTy) == sizeof(int32_t));
+
+void checkByteOrder() {
+  if constexpr (std::endian::native != std::endian::little)
+    throw std::runtime_error("binary nets need a little-endian host");
+}
+
+// Read-only view of a whole file, mapped where the platform allows it.
+class MappedFileTy final {
+  const char *Data = nullptr;
+  size_t Size = 0;
+#if !ALGO_HAS_MMAP
+  std::vector<char> Buffer;
+#endif
+
+public:
+  explicit MappedFileTy(const std::string &Path) {
+#if ALGO_HAS_MMAP
+    int FD = ::open(Path.c_str(), O_RDONLY);
+    if (FD < 0)
+      throw std::runtime_error("cannot open " + Path);
+    struct stat St;
+    if (::fstat(FD, &St) != 0) {
+      ::close(FD);
+      throw std::runtime_error("cannot stat " + Path);
+    }
+    Size = St.st_size;
+    if (Size != 0) {
+      void *Addr = ::mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, FD, 0);
+      if (Addr == MAP_FAILED) {
+        ::close(FD);
+        throw std::runtime_error("cannot map " + Path);
+      }
+      Data = static_cast<const char *>(Addr);
+    }
+    ::close(FD);
+#else
+    std::ifstream IS{Path, std::ios::binary};
+    if (!IS)
+      throw std::runtime_error("cannot open " + Path);
+    Buffer.assign(std::istreambuf_iterator<char>{IS}, {});
+    Data = Buffer.data();
+    Size = Buffer.size();
+#endif
+  }
+
+  ~MappedFileTy() {
+#if ALGO_HAS_MMAP
+    if (Data)
+      ::munmap(const_cast<char *>(Data), Size);
+#endif
+  }
+
+  MappedFileTy(const MappedFileTy &) = delete;
+  MappedFileTy &operator=(const MappedFileTy &) = delete;
+
+  const char *data() const { return Data; }
+  size_t size() const { return Size; }
+};
+
+template <typename T>
+const T *getTable(const MappedFileTy &File, uint64_t &Offset, uint64_t Count) {
+  if (Count > (File.size() - Offset) / sizeof(T))
+    throw std::runtime_error("truncated binary net");
+  auto *Table = reinterpret_cast<const T *>(File.data() + Offset);
+  Offset += Count * sizeof(T);
+  Offset = (Offset + 7) / 8 * 8;
+  Offset = std::min<uint64_t>(Offset, File.size());
+  return Table;
+}
+
+NodeKindTy toNodeKind(uint32_t Kind) {
+  switch (Kind) {
+  case static_cast<uint32_t>(NodeKindTy::Buffer):
+    return NodeKindTy::Buffer;
+  case static_cast<uint32_t>(NodeKindTy::Steiner):
+    return NodeKindTy::Steiner;
+  case static_cast<uint32_t>(NodeKindTy::Point):
+    return NodeKindTy::Point;
+  default:
+    throw std::runtime_error("unknown node kind in binary net");
+  }
+}
+
+template <typename T> void writeTable(std::ostream &OS, const T *Data,
+                                      size_t Count) {
+  OS.write(reinterpret_cast<const char *>(Data), Count * sizeof(T));
+  static constexpr char Padding[8] = {};
+  OS.write(Padding, (8 - Count * sizeof(T) % 8) % 8);
+}
+
+} // namespace
+
+bool isRCGraphBinary(const std::string &Path) {
+  std::ifstream IS{Path, std::ios::binary};
+  char Head[sizeof(Magic)] = {};
+  IS.read(Head, sizeof(Head));
+  return IS && std::memcmp(Head, Magic, sizeof(Magic)) == 0;
+}
+
+RCGraphTy readRCGraphBinary(const std::string &Path) {
+  checkByteOrder();
+  MappedFileTy File{Path};
+  uint64_t Offset = 0;
+  const auto &Header = *getTable<HeaderTy>(File, Offset, 1);
+  if (std::memcmp(Header.Magic, Magic, sizeof(Magic)) != 0)
+    throw std::runtime_error(Path + " is not a binary net");
+  if (Header.Version != Version)
+    throw std::runtime_error("unsupported binary net version " +
+                             std::to_string(Header.Version));
+  if (Header.Root >= Header.NumNodes ||
+      Header.NumEdges + 1 != Header.NumNodes)
+    throw std::runtime_error("binary net is not a tree");
+
+  const auto *Nodes = getTable<BinaryNodeTy>(File, Offset, Header.NumNodes);
+  const auto *Edges = getTable<BinaryEdgeTy>(File, Offset, Header.NumEdges);
+  const auto *Points = getTable<BinaryPointTy>(File, Offset, Header.NumPoints);
+  const auto *Chars = getTable<char>(File, Offset, Header.NumChars);
+
+  RCGraphTy G;
+  for (uint32_t Idx = 0; Idx != Header.NumNodes; ++Idx) {
+    const auto &Node = Nodes[Idx];
+    if (Node.NameBegin > Header.NumChars ||
+        Node.NameSize > Header.NumChars - Node.NameBegin)
+      throw std::runtime_error("node name out of the string table");
+    G.addNode(NodeTy{
+        .Kind = toNodeKind(Node.Kind),
+        .Name = std::string(Chars + Node.NameBegin, Node.NameSize),
+        .P = PointTy{Node.X, Node.Y},
+        .Capacity = Node.Capacity,
+        .RAT = Node.RAT,
+    });
+  }
+  G.setRoot(Header.Root);
+
+  for (uint32_t Idx = 0; Idx != Header.NumEdges; ++Idx) {
+    const auto &Edge = Edges[Idx];
+    if (Edge.First >= Header.NumNodes || Edge.Last >= Header.NumNodes ||
+        Edge.PointsBegin > Header.NumPoints ||
+        Edge.NumPoints > Header.NumPoints - Edge.PointsBegin)
+      throw std::runtime_error("edge out of the node or point table");
+    if (Edge.Last == Header.Root)
+      throw std::runtime_error("binary net root has a parent");
+    if (G.getParent(Edge.Last) != RCGraphTy::invalidEdgeId())
+      throw std::runtime_error("binary net node " + std::to_string(Edge.Last) +
+                               " has more than one parent");
+    auto Ps = PointsTy{};
+    Ps.reserve(Edge.NumPoints);
+    for (auto *P = Points + Edge.PointsBegin,
+              *End = Points + Edge.PointsBegin + Edge.NumPoints;
+         P != End; ++P)
+      Ps.emplace_back(P->X, P->Y);
+    G.addEdge(Edge.First, Edge.Last, EdgeTy{.Ps = std::move(Ps)});
+  }
+
+  // Every node has a single parent by now, a node out of reach of the root
+  // sits on a cycle.
+  std::vector<RCGraphTy::NodeIdTy> Reached{Header.Root};
+  for (size_t Idx = 0; Idx != Reached.size(); ++Idx)
+    for (auto EId : G.getChildren(Reached[Idx]))
+      Reached.push_back(G.getEdgeNodeLast(EId));
+  if (Reached.size() != Header.NumNodes)
+    throw std::runtime_error("binary net has nodes out of reach of the root");
+  return G;
+}
+
+void writeRCGraphBinary(const RCGraphTy &G, std::ostream &OS) {
+  checkByteOrder();
+  using NodeIdTy = RCGraphTy::NodeIdTy;
+
+  // Only the tree hanging from the root is written.
+  std::vector<NodeIdTy> NIds{G.getRoot()};
+  std::vector<RCGraphTy::EdgeIdTy> EIds;
+  for (size_t Idx = 0; Idx != NIds.size(); ++Idx) {
+    for (auto EId : G.getChildren(NIds[Idx])) {
+      EIds.push_back(EId);
+      NIds.push_back(G.getEdgeNodeLast(EId));
+    }
+  }
+  std::sort(NIds.begin(), NIds.end());
+  std::sort(EIds.begin(), EIds.end());
+
+  std::vector<uint32_t> Index(G.getNodeIdBound());
+  std::vector<BinaryNodeTy> Nodes;
+  std::string Chars;
+  for (auto NId : NIds) {
+    Index[NId] = Nodes.size();
+    const auto &Node = G.getNode(NId);
+    Nodes.push_back(BinaryNodeTy{
+        .X = Node.P.X,
+        .Y = Node.P.Y,
+        .Capacity = Node.Capacity,
+        .RAT = Node.RAT,
+        .NameBegin = static_cast<uint32_t>(Chars.size()),
+        .NameSize = static_cast<uint32_t>(Node.Name.size()),
+        .Kind = static_cast<uint32_t>(Node.Kind),
+        .Reserved = 0,
+    });
+    Chars += Node.Name;
+  }
+
+  std::vector<BinaryEdgeTy> Edges;
+  std::vector<BinaryPointTy> Points;
+  for (auto EId : EIds) {
+    const auto &Ps = G.getEdge(EId).Ps;
+    Edges.push_back(BinaryEdgeTy{
+        .First = Index[G.getEdgeNodeFirst(EId)],
+        .Last = Index[G.getEdgeNodeLast(EId)],
+        .PointsBegin = Points.size(),
+        .NumPoints = Ps.size(),
+    });
+    for (auto &&P : Ps)
+      Points.push_back(BinaryPointTy{P.X, P.Y});
+  }
+
+  HeaderTy Header{};
+  std::memcpy(Header.Magic, Magic, sizeof(Magic));
+  Header.Version = Version;
+  Header.NumNodes = Nodes.size();
+  Header.NumEdges = Edges.size();
+  Header.Root = Index[G.getRoot()];
+  Header.NumPoints = Points.size();
+  Header.NumChars = Chars.size();
+
+  writeTable(OS, &Header, 1);
+  writeTable(OS, Nodes.data(), Nodes.size());
+  writeTable(OS, Edges.data(), Edges.size());
+  writeTable(OS, Points.data(), Points.size());
+  writeTable(OS, Chars.data(), Chars.size());
+  if (!OS)
+    throw std::runtime_error("cannot write binary net");
+}
+
+RCGraphTy loadRCGraph(const std::string &Path) {
+  if (isRCGraphBinary(Path))
+    return readRCGraphBinary(Path);
+  std::ifstream IS{Path};
+  if (!IS)
+    throw std::runtime_error("cannot open " + Path);
+  return readRCGraph(IS);
+}
+
+} // namespace algo
@@ -0,0 +1,810 @@
+#include "ShiLiAlgorithm.h"
+#include "CandidateDAG.h"
+#include "FrozenRCGraph.h"
+
+#include <limits>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace algo;
+
+namespace {
+
+using FloatTy = NodeTy::FloatTy;
+
+constexpr FloatTy Infinity = std::numeric_limits<FloatTy>::infinity();
+
+// Pending wire update of a subtree: C += AddC, RAT -= SubRAT + SubRATPerC * C,
+// where C is the capacity before the update.
+struct WireTagTy {
+  FloatTy AddC = 0;
+  FloatTy SubRAT = 0;
+  FloatTy SubRATPerC = 0;
+
+  bool empty() const { return AddC == 0 && SubRAT == 0 && SubRATPerC == 0; }
+
+  // Tag equivalent to applying this one and then Next.
+  WireTagTy then(const WireTagTy &Next) const {
+    return WireTagTy{
+        .AddC = AddC + Next.AddC,
+        .SubRAT = SubRAT + Next.SubRAT + Next.SubRATPerC * AddC,
+        .SubRATPerC = SubRATPerC + Next.SubRATPerC,
+    };
+  }
+};
+
+// Slope of the RAT over capacity from entry (C0, RAT0) to (C1, RAT1). For
+// consecutive frontier entries a non-positive slope means that the second
+// one is dominated.
+FloatTy slope(FloatTy C0, FloatTy RAT0, FloatTy C1, FloatTy RAT1) {
+  if (RAT1 <= RAT0)
+    return -Infinity;
+  if (C1 <= C0)
+    return Infinity;
+  return (RAT1 - RAT0) / (C1 - C0);
+}
+
+// Pool of implicit treaps, each holding a pruned frontier ordered by
+// capacity. A wire segment shears the whole frontier in the (C, RAT) plane,
+// so it is kept as a lazy tag, and so are the slopes between neighbours:
+// Slope to the predecessor finds entries dominated after a wire, HullSlope to
+// the next vertex of the upper convex hull finds the entry that gives the
+// best RAT behind a buffer. Both shift uniformly under a wire tag.
+//
+// A merge inserts the smaller frontier into the larger one. Each entry of the
+// smaller frontier limits the RAT of a range of the larger one and adds its
+// capacity to it, which is a lazy tag too, and so is the join of its record.
+// Ranges only move apart, so slopes and hull edges inside a range stay valid
+// and only the edges across range boundaries need repair.
+class FrontierForest final {
+public:
+  using TreeTy = unsigned;
+
+  static constexpr TreeTy Empty = std::numeric_limits<TreeTy>::max();
+
+private:
+  // Positions [Begin, End) of a part of a merged frontier.
+  struct PartTy {
+    unsigned Begin;
+    unsigned End;
+  };
+
+  // Pending joins of the records of a subtree: every record R becomes
+  // join(join(Lhs, R), Rhs).
+  struct JoinTagTy {
+    const CandidateRecordTy *Lhs;
+    const CandidateRecordTy *Rhs;
+  };
+
+  static constexpr unsigned NoJoin = std::numeric_limits<unsigned>::max();
+
+  // Vertices of a hull under repair: the old hull vertices of one part with
+  // ranks [First, Last], or else the entry at position First.
+  struct HullRunTy {
+    unsigned First;
+    unsigned Last;
+    unsigned Part;
+    bool Old;
+  };
+
+  struct EntryTy {
+    FrontierEntryTy Value;
+    unsigned Priority;
+    TreeTy Left = Empty;
+    TreeTy Right = Empty;
+    WireTagTy Tag;
+    // Merges are rare next to wires, so their tags live in Joins and the
+    // entry only keeps an index, which fits in its padding.
+    unsigned Join = NoJoin;
+
+    FloatTy Slope = Infinity;
+    FloatTy HullSlope = Infinity;
+
+    unsigned Size = 1;
+    unsigned HullCount = 0;
+    FloatTy MinSlope = Infinity;
+    FloatTy MinHullSlope = Infinity;
+    bool IsHull = false;
+  };
+
+  CandidateDAG &DAG;
+  std::vector<EntryTy> Entries;
+  std::vector<TreeTy> FreeEntries;
+  std::vector<JoinTagTy> Joins;
+  std::vector<unsigned> FreeJoins;
+  std::minstd_rand Rng;
+
+  unsigned size(TreeTy T) const { return T == Empty ? 0 : Entries[T].Size; }
+
+  unsigned hullCount(TreeTy T) const {
+    return T == Empty ? 0 : Entries[T].HullCount;
+  }
+
+  FloatTy minSlope(TreeTy T) const {
+    return T == Empty ? Infinity : Entries[T].MinSlope;
+  }
+
+  FloatTy minHullSlope(TreeTy T) const {
+    return T == Empty ? Infinity : Entries[T].MinHullSlope;
+  }
+
+  TreeTy create(const FrontierEntryTy &Value) {
+    EntryTy E;
+    E.Value = Value;
+    E.Priority = Rng();
+    if (FreeEntries.empty()) {
+      Entries.push_back(E);
+      return Entries.size() - 1;
+    }
+    TreeTy T = FreeEntries.back();
+    FreeEntries.pop_back();
+    Entries[T] = E;
+    return T;
+  }
+
+  void apply(TreeTy T, const WireTagTy &Tag) {
+    if (T == Empty)
+      return;
+    auto &E = Entries[T];
+    auto C = E.Value.Capacity;
+    E.Value.Capacity = C + Tag.AddC;
+    E.Value.RAT -= Tag.SubRAT + Tag.SubRATPerC * C;
+    E.Tag = E.Tag.then(Tag);
+    E.Slope -= Tag.SubRATPerC;
+    E.HullSlope -= Tag.SubRATPerC;
+    E.MinSlope -= Tag.SubRATPerC;
+    E.MinHullSlope -= Tag.SubRATPerC;
+  }
+
+  void join(TreeTy T, const JoinTagTy &Tag) {
+    if (T == Empty)
+      return;
+    auto &E = Entries[T];
+    E.Value.Record = DAG.join(DAG.join(Tag.Lhs, E.Value.Record), Tag.Rhs);
+    if (E.Join != NoJoin) {
+      auto &Pending = Joins[E.Join];
+      Pending = {DAG.join(Tag.Lhs, Pending.Lhs),
+                 DAG.join(Pending.Rhs, Tag.Rhs)};
+      return;
+    }
+    if (FreeJoins.empty()) {
+      E.Join = Joins.size();
+      Joins.push_back(Tag);
+      return;
+    }
+    E.Join = FreeJoins.back();
+    FreeJoins.pop_back();
+    Joins[E.Join] = Tag;
+  }
+
+  void push(TreeTy T) {
+    auto &E = Entries[T];
+    if (!E.Tag.empty()) {
+      apply(E.Left, E.Tag);
+      apply(E.Right, E.Tag);
+      E.Tag = WireTagTy{};
+    }
+    if (E.Join != NoJoin) {
+      auto Tag = Joins[E.Join];
+      FreeJoins.push_back(std::exchange(E.Join, NoJoin));
+      join(E.Left, Tag);
+      join(E.Right, Tag);
+    }
+  }
+
+  void pull(TreeTy T) {
+    auto &E = Entries[T];
+    E.Size = 1 + size(E.Left) + size(E.Right);
+    E.HullCount = E.IsHull + hullCount(E.Left) + hullCount(E.Right);
+    E.MinSlope = std::min({E.Slope, minSlope(E.Left), minSlope(E.Right)});
+    E.MinHullSlope = std::min({E.IsHull ? E.HullSlope : Infinity,
+                               minHullSlope(E.Left), minHullSlope(E.Right)});
+  }
+
+  // Splits off the first K entries.
+  std::pair<TreeTy, TreeTy> split(TreeTy T, unsigned K) {
+    if (T == Empty)
+      return {Empty, Empty};
+    push(T);
+    auto &E = Entries[T];
+    if (size(E.Left) >= K) {
+      auto [L, R] = split(E.Left, K);
+      Entries[T].Left = R;
+      pull(T);
+      return {L, T};
+    }
+    auto [L, R] = split(E.Right, K - size(E.Left) - 1);
+    Entries[T].Right = L;
+    pull(T);
+    return {T, R};
+  }
+
+  TreeTy concat(TreeTy L, TreeTy R) {
+    if (L == Empty)
+      return R;
+    if (R == Empty)
+      return L;
+    if (Entries[L].Priority > Entries[R].Priority) {
+      push(L);
+      Entries[L].Right = concat(Entries[L].Right, R);
+      pull(L);
+      return L;
+    }
+    push(R);
+    Entries[R].Left = concat(L, Entries[R].Left);
+    pull(R);
+    return R;
+  }
+
+  // Entry at position K with all pending tags above it applied.
+  TreeTy at(TreeTy T, unsigned K) {
+    while (true) {
+      push(T);
+      auto &E = Entries[T];
+      if (K < size(E.Left)) {
+        T = E.Left;
+      } else if (K == size(E.Left)) {
+        return T;
+      } else {
+        K -= size(E.Left) + 1;
+        T = E.Right;
+      }
+    }
+  }
+
+  const FrontierEntryTy &valueAt(TreeTy T, unsigned K) {
+    return Entries[at(T, K)].Value;
+  }
+
+  template <typename FnTy> void modify(TreeTy T, unsigned K, FnTy Fn) {
+    push(T);
+    auto &E = Entries[T];
+    auto LeftSize = size(E.Left);
+    if (K < LeftSize)
+      modify(E.Left, K, Fn);
+    else if (K == LeftSize)
+      Fn(E);
+    else
+      modify(E.Right, K - LeftSize - 1, Fn);
+    pull(T);
+  }
+
+  template <typename PredTy> unsigned countWhile(TreeTy T, PredTy Pred) {
+    unsigned Count = 0;
+    while (T != Empty) {
+      push(T);
+      auto &E = Entries[T];
+      if (Pred(E.Value)) {
+        Count += size(E.Left) + 1;
+        T = E.Right;
+      } else {
+        T = E.Left;
+      }
+    }
+    return Count;
+  }
+
+  // Aggregates are shifted by every tag on their own, so after a push they
+  // may differ from the children ones by rounding. Compare fresh values only.
+  unsigned findMinSlope(TreeTy T) {
+    unsigned K = 0;
+    while (true) {
+      push(T);
+      auto &E = Entries[T];
+      auto LeftMin = minSlope(E.Left);
+      if (E.Left != Empty && LeftMin <= E.Slope &&
+          LeftMin <= minSlope(E.Right)) {
+        T = E.Left;
+      } else if (E.Right == Empty || E.Slope <= minSlope(E.Right)) {
+        return K + size(E.Left);
+      } else {
+        K += size(E.Left) + 1;
+        T = E.Right;
+      }
+    }
+  }
+
+  std::optional<FrontierEntryTy> firstHullAtMost(TreeTy T, FloatTy S) {
+    if (minHullSlope(T) > S)
+      return std::nullopt;
+    push(T);
+    auto &E = Entries[T];
+    if (auto Found = firstHullAtMost(E.Left, S))
+      return Found;
+    if (E.IsHull && E.HullSlope <= S)
+      return E.Value;
+    return firstHullAtMost(E.Right, S);
+  }
+
+  // Number of hull vertices among the first K entries.
+  unsigned hullRank(TreeTy T, unsigned K) {
+    unsigned Rank = 0;
+    while (T != Empty && K != 0) {
+      auto &E = Entries[T];
+      auto LeftSize = size(E.Left);
+      if (K <= LeftSize) {
+        T = E.Left;
+      } else {
+        Rank += hullCount(E.Left) + E.IsHull;
+        K -= LeftSize + 1;
+        T = E.Right;
+      }
+    }
+    return Rank;
+  }
+
+  // Position of the hull vertex number H.
+  unsigned selectHull(TreeTy T, unsigned H) {
+    unsigned K = 0;
+    while (true) {
+      auto &E = Entries[T];
+      auto LeftHull = hullCount(E.Left);
+      if (H < LeftHull) {
+        T = E.Left;
+      } else if (H == LeftHull && E.IsHull) {
+        return K + size(E.Left);
+      } else {
+        H -= LeftHull + E.IsHull;
+        K += size(E.Left) + 1;
+        T = E.Right;
+      }
+    }
+  }
+
+  std::optional<unsigned> hullBefore(TreeTy T, unsigned K) {
+    auto Rank = hullRank(T, K);
+    if (Rank == 0)
+      return std::nullopt;
+    return selectHull(T, Rank - 1);
+  }
+
+  std::optional<unsigned> hullFrom(TreeTy T, unsigned K) {
+    auto Rank = hullRank(T, K);
+    if (Rank == hullCount(T))
+      return std::nullopt;
+    return selectHull(T, Rank);
+  }
+
+  void updateSlope(TreeTy T, unsigned K) {
+    if (K == 0 || K >= size(T))
+      return;
+    auto Prev = valueAt(T, K - 1);
+    auto Cur = valueAt(T, K);
+    auto S = slope(Prev.Capacity, Prev.RAT, Cur.Capacity, Cur.RAT);
+    modify(T, K, [S](EntryTy &E) { E.Slope = S; });
+  }
+
+  void setHull(TreeTy T, unsigned K, bool IsHull, FloatTy HullSlope) {
+    modify(T, K, [IsHull, HullSlope](EntryTy &E) {
+      E.IsHull = IsHull;
+      E.HullSlope = IsHull ? HullSlope : Infinity;
+    });
+  }
+
+  // Points the hull vertex at position K to the vertex at position Next.
+  void linkHull(TreeTy T, unsigned K, std::optional<unsigned> Next) {
+    auto S = -Infinity;
+    if (Next) {
+      auto From = valueAt(T, K);
+      auto To = valueAt(T, *Next);
+      S = slope(From.Capacity, From.RAT, To.Capacity, To.RAT);
+    }
+    setHull(T, K, /*IsHull=*/true, S);
+  }
+
+  void eraseRange(TreeTy &T, unsigned First, unsigned Count) {
+    auto [L, Rest] = split(T, First);
+    auto [M, R] = split(Rest, Count);
+    release(M);
+    T = concat(L, R);
+  }
+
+  // Removes entries that became dominated, each found in logarithmic time
+  // through the minimal slope to a predecessor.
+  void pruneDominated(TreeTy &T) {
+    while (minSlope(T) <= 0) {
+      auto K = findMinSlope(T);
+      assert(K != 0 && "First entry has no predecessor");
+      auto Prev = valueAt(T, K - 1);
+      auto Cur = valueAt(T, K);
+      auto S = slope(Prev.Capacity, Prev.RAT, Cur.Capacity, Cur.RAT);
+      if (S > 0) {
+        // Accumulated rounding, the entry is still alive.
+        modify(T, K, [S](EntryTy &E) { E.Slope = S; });
+        continue;
+      }
+      bool WasHull = Entries[at(T, K)].IsHull;
+      eraseRange(T, K, 1);
+      updateSlope(T, K);
+      // Shearing keeps the hull, so a dominated vertex is followed only by
+      // dominated ones and its predecessor on the hull simply moves on.
+      if (WasHull)
+        linkHull(T, *hullBefore(T, K), hullFrom(T, K));
+    }
+  }
+
+  TreeTy buildTreap(const std::vector<TreeTy> &Ordered) {
+    std::vector<TreeTy> Stack;
+    for (auto T : Ordered) {
+      auto Last = Empty;
+      while (!Stack.empty() &&
+             Entries[Stack.back()].Priority < Entries[T].Priority) {
+        Last = Stack.back();
+        Stack.pop_back();
+      }
+      Entries[T].Left = Last;
+      if (!Stack.empty())
+        Entries[Stack.back()].Right = T;
+      Stack.push_back(T);
+    }
+    if (Stack.empty())
+      return Empty;
+    pullTree(Stack.front());
+    return Stack.front();
+  }
+
+  void pullTree(TreeTy T) {
+    if (T == Empty)
+      return;
+    pullTree(Entries[T].Left);
+    pullTree(Entries[T].Right);
+    pull(T);
+  }
+
+  void flatten(TreeTy T, FrontierTy &Frontier) {
+    if (T == Empty)
+      return;
+    push(T);
+    flatten(Entries[T].Left, Frontier);
+    Frontier.push_back(Entries[T].Value);
+    flatten(Entries[T].Right, Frontier);
+  }
+
+  // Relinks the hull after a merge. Parts are the ranges of the larger
+  // frontier and the entries added between them. Within a range the old hull
+  // vertices keep their edges and the entries below those edges stay below
+  // them, so only the entries before the first and after the last old vertex
+  // of each range may join the hull. The hull is rebuilt by a monotone chain
+  // that keeps the old vertices of a range as one run: the chain stays convex
+  // inside a run, so only vertices that leave the hull and the ends of runs
+  // are visited.
+  void repairHull(TreeTy T, const std::vector<PartTy> &Parts) {
+    std::vector<HullRunTy> Runs;
+    std::vector<unsigned> Dropped;
+    // Vertex number Back from the end of the chain.
+    auto last = [&](unsigned Back) -> std::optional<FrontierEntryTy> {
+      for (auto It = Runs.rbegin(); It != Runs.rend(); ++It) {
+        auto Count = It->Old ? It->Last - It->First + 1 : 1;
+        if (Back < Count)
+          return valueAt(T, It->Old ? selectHull(T, It->Last - Back)
+                                    : It->First);
+        Back -= Count;
+      }
+      return std::nullopt;
+    };
+    auto add = [&](const HullRunTy &Vertex, const FrontierEntryTy &Value) {
+      while (auto Prev = last(1)) {
+        if (cross(*Prev, *last(0), Value) < 0)
+          break;
+        auto &Top = Runs.back();
+        if (!Top.Old) {
+          Runs.pop_back();
+          continue;
+        }
+        Dropped.push_back(selectHull(T, Top.Last));
+        if (Top.First == Top.Last--)
+          Runs.pop_back();
+      }
+      Runs.push_back(Vertex);
+    };
+    auto addEntries = [&](unsigned Begin, unsigned End, unsigned Part) {
+      for (auto K = Begin; K < End; ++K)
+        add({K, K, Part, /*Old=*/false}, valueAt(T, K));
+    };
+
+    for (unsigned Part = 0; Part != Parts.size(); ++Part) {
+      auto [Begin, End] = Parts[Part];
+      auto First = hullFrom(T, Begin);
+      if (!First || *First >= End) {
+        addEntries(Begin, End, Part);
+        continue;
+      }
+      auto Last = *hullBefore(T, End);
+      addEntries(Begin, *First, Part);
+      auto LastRank = hullRank(T, Last);
+      for (auto Rank = hullRank(T, *First); Rank <= LastRank; ++Rank) {
+        auto Value = valueAt(T, selectHull(T, Rank));
+        add({Rank, Rank, Part, /*Old=*/true}, Value);
+        if (Rank == LastRank)
+          break;
+        // Once the next vertex keeps this one, the rest of the run is kept.
+        auto Prev = last(1);
+        if (!Prev ||
+            cross(*Prev, Value, valueAt(T, selectHull(T, Rank + 1))) < 0) {
+          Runs.back().Last = LastRank;
+          break;
+        }
+      }
+      addEntries(Last + 1, End, Part);
+    }
+
+    // Positions are taken before any flag changes, since flags shift ranks.
+    std::vector<std::pair<unsigned, unsigned>> Ends;
+    Ends.reserve(Runs.size());
+    for (auto &&Run : Runs) {
+      if (Run.Old)
+        Ends.emplace_back(selectHull(T, Run.First), selectHull(T, Run.Last));
+      else
+        Ends.emplace_back(Run.First, Run.First);
+    }
+    for (auto K : Dropped)
+      setHull(T, K, /*IsHull=*/false, Infinity);
+    for (size_t Idx = 0; Idx + 1 < Runs.size(); ++Idx) {
+      const auto &Run = Runs[Idx];
+      const auto &Next = Runs[Idx + 1];
+      // An edge between consecutive old vertices of one range is the same.
+      if (Run.Old && Next.Old && Run.Part == Next.Part &&
+          Next.First == Run.Last + 1)
+        continue;
+      linkHull(T, Ends[Idx].second, Ends[Idx + 1].first);
+    }
+    linkHull(T, Ends.back().second, std::nullopt);
+  }
+
+public:
+  explicit FrontierForest(CandidateDAG &DAG) : DAG(DAG) {}
+
+  // Entries are recycled through the free list, so the pool only grows up
+  // to the largest number of entries alive at the same time.
+  size_t getPeakBytes() const { return Entries.size() * sizeof(EntryTy); }
+
+  void release(TreeTy T) {
+    if (T == Empty)
+      return;
+    release(Entries[T].Left);
+    release(Entries[T].Right);
+    if (Entries[T].Join != NoJoin)
+      FreeJoins.push_back(Entries[T].Join);
+    FreeEntries.push_back(T);
+  }
+
+  // Frontier must be sorted by capacity and pruned.
+  TreeTy build(const FrontierTy &Frontier) {
+    std::vector<TreeTy> Ordered;
+    for (auto &&Value : Frontier) {
+      auto T = create(Value);
+      if (!Ordered.empty()) {
+        const auto &Prev = Entries[Ordered.back()].Value;
+        Entries[T].Slope =
+            slope(Prev.Capacity, Prev.RAT, Value.Capacity, Value.RAT);
+      }
+      Ordered.push_back(T);
+    }
+    HullTy Hull;
+    buildHull(Frontier, Hull);
+    for (size_t Idx = 0; Idx != Hull.size(); ++Idx) {
+      auto &E = Entries[Ordered[Hull[Idx]]];
+      E.IsHull = true;
+      E.HullSlope = -Infinity;
+      if (Idx + 1 != Hull.size()) {
+        const auto &Next = Frontier[Hull[Idx + 1]];
+        E.HullSlope = slope(E.Value.Capacity, E.Value.RAT, Next.Capacity,
+                            Next.RAT);
+      }
+    }
+    auto T = buildTreap(Ordered);
+    pruneDominated(T);
+    return T;
+  }
+
+  FrontierTy flatten(TreeTy T) {
+    FrontierTy Frontier;
+    Frontier.reserve(size(T));
+    flatten(T, Frontier);
+    return Frontier;
+  }
+
+  void addWire(TreeTy &T, const WireTagTy &Tag) {
+    apply(T, Tag);
+    pruneDominated(T);
+  }
+
+  // Entry maximizing RAT - R * C, that is the first hull vertex where the
+  // hull becomes flatter than R. The last vertex has slope -inf, so it
+  // always exists.
+  FrontierEntryTy bestDriven(TreeTy T, FloatTy R) {
+    assert(T != Empty);
+    return *firstHullAtMost(T, R);
+  }
+
+  // Same result as mergeFrontiers on the flattened frontiers, with the
+  // records of Lhs first in every join. Takes time logarithmic in the larger
+  // frontier per entry of the smaller one, per hull vertex that changes and
+  // per entry at the ends of ranges that no old hull edge covers.
+  TreeTy merge(TreeTy Lhs, TreeTy Rhs) {
+    bool SmallIsLhs = size(Lhs) < size(Rhs);
+    auto Rest = SmallIsLhs ? Rhs : Lhs;
+    auto Small = flatten(SmallIsLhs ? Lhs : Rhs);
+    release(SmallIsLhs ? Lhs : Rhs);
+
+    auto T = Empty;
+    std::vector<PartTy> Parts;
+    auto append = [&](TreeTy Part) {
+      // Rounding may collapse two sums into one capacity.
+      auto Size = size(T);
+      if (Size != 0 &&
+          valueAt(T, Size - 1).Capacity >= valueAt(Part, 0).Capacity) {
+        eraseRange(T, --Size, 1);
+        if (--Parts.back().End == Parts.back().Begin)
+          Parts.pop_back();
+      }
+      Parts.push_back({Size, Size + size(Part)});
+      T = concat(T, Part);
+    };
+    for (auto &&S : Small) {
+      if (Rest == Empty)
+        break;
+      // Entries up to the RAT of S are limited by their own RAT and carry
+      // S, the first entry above it is limited by S.
+      auto [Range, Above] = split(
+          Rest, countWhile(Rest, [&S](const FrontierEntryTy &E) {
+            return E.RAT <= S.RAT;
+          }));
+      Rest = Above;
+      bool Tie = false;
+      if (Range != Empty) {
+        Tie = valueAt(Range, size(Range) - 1).RAT == S.RAT;
+        apply(Range, WireTagTy{.AddC = S.Capacity});
+        join(Range, SmallIsLhs ? JoinTagTy{S.Record, nullptr}
+                               : JoinTagTy{nullptr, S.Record});
+        append(Range);
+      }
+      if (Rest != Empty && !Tie) {
+        auto First = valueAt(Rest, 0);
+        append(create(FrontierEntryTy{
+            .Capacity = First.Capacity + S.Capacity,
+            .RAT = S.RAT,
+            .Record = SmallIsLhs ? DAG.join(S.Record, First.Record)
+                                 : DAG.join(First.Record, S.Record),
+        }));
+      }
+    }
+    release(Rest);
+
+    for (auto &&Part : Parts)
+      updateSlope(T, Part.Begin);
+    repairHull(T, Parts);
+    return T;
+  }
+
+  void insert(TreeTy &T, const FrontierEntryTy &Value) {
+    auto K = countWhile(T, [&Value](const FrontierEntryTy &E) {
+      return E.Capacity < Value.Capacity;
+    });
+    if (K != 0 && valueAt(T, K - 1).RAT >= Value.RAT)
+      return;
+    if (K != size(T) && valueAt(T, K).Capacity == Value.Capacity &&
+        valueAt(T, K).RAT >= Value.RAT)
+      return;
+    // Entries from K on with RAT not above the new one are dominated by it.
+    auto Dominated = countWhile(T, [&Value](const FrontierEntryTy &E) {
+                       return E.RAT <= Value.RAT;
+                     }) -
+                     K;
+    eraseRange(T, K, Dominated);
+
+    auto [L, R] = split(T, K);
+    T = concat(concat(L, create(Value)), R);
+    updateSlope(T, K);
+    updateSlope(T, K + 1);
+
+    // Dropping dominated entries never uncovers other ones, so the hull
+    // changes only around the new entry.
+    auto HullLhs = hullBefore(T, K);
+    auto HullRhs = hullFrom(T, K + 1);
+    if (HullLhs && HullRhs &&
+        cross(valueAt(T, *HullLhs), Value, valueAt(T, *HullRhs)) >= 0) {
+      linkHull(T, *HullLhs, HullRhs);
+      return;
+    }
+    while (HullLhs) {
+      auto Prev = hullBefore(T, *HullLhs);
+      if (!Prev || cross(valueAt(T, *Prev), valueAt(T, *HullLhs), Value) < 0)
+        break;
+      setHull(T, *HullLhs, /*IsHull=*/false, Infinity);
+      HullLhs = Prev;
+    }
+    while (HullRhs) {
+      auto Next = hullFrom(T, *HullRhs + 1);
+      if (!Next || cross(Value, valueAt(T, *HullRhs), valueAt(T, *Next)) < 0)
+        break;
+      setHull(T, *HullRhs, /*IsHull=*/false, Infinity);
+      HullRhs = Next;
+    }
+    if (HullLhs)
+      linkHull(T, *HullLhs, K);
+    linkHull(T, K, HullRhs);
+  }
+};
+
+} // namespace
+
+namespace algo {
+
+SolutionTy shiLiBufferInsertion(const RCGraphTy &G,
+                                const CandidatePolicyTy &Candidates,
+                                EngineStatsTy *Stats) {
+  using TreeTy = FrontierForest::TreeTy;
+
+  auto &DAG = acquireThreadDAG();
+  FrontierForest Forest{DAG};
+  auto F = freeze(G);
+  const auto &Tech = G.getAttrs().getTechnology();
+  const auto &Library = G.getAttrs().getModules(ModuleKind::Buffer);
+  const Module &Driver = G.getAttrs().getModule(ModuleKind::Buffer,
+                                                G.getNode(G.getRoot()).Name);
+
+  std::vector<TreeTy> Frontiers(F.getNodeIdBound(), FrontierForest::Empty);
+  std::vector<FrontierEntryTy> Buffered;
+  for (auto NId : F.getPostOrder()) {
+    const NodeTy &Node = F.getNode(NId);
+
+    auto T = FrontierForest::Empty;
+    if (Node.Kind == NodeKindTy::Point) {
+      assert(F.getChildren(NId).empty());
+      T = Forest.build(FrontierTy{{Node.Capacity, Node.RAT, nullptr}});
+    }
+    for (auto ChildId : F.getChildNodes(NId)) {
+      auto Child = std::exchange(Frontiers[ChildId], FrontierForest::Empty);
+      if (T == FrontierForest::Empty) {
+        T = Child;
+        continue;
+      }
+      T = Forest.merge(T, Child);
+    }
+
+    if (NId == G.getRoot()) {
+      auto Best = Forest.bestDriven(T, Driver.R);
+      Best.RAT -= Driver.K + Driver.R * Best.Capacity;
+      Best.Capacity = Driver.C;
+      if (Stats) {
+        Stats->PeakFrontierBytes = Forest.getPeakBytes();
+        Stats->Records = DAG.getStats();
+      }
+      return collectSolution(Best, Node.P);
+    }
+
+    auto EId = F.getParent(NId);
+    auto Position = Node.P;
+    for (auto &&Point : splitEdge(F.getPoints(EId), Candidates)) {
+      FloatTy Length = Position.distance(Point);
+      Position = Point;
+      Forest.addWire(T, WireTagTy{
+                            .AddC = Tech.UnitC * Length,
+                            .SubRAT = Tech.UnitR * Tech.UnitC * Length *
+                                      Length / 2,
+                            .SubRATPerC = Tech.UnitR * Length,
+                        });
+
+      Buffered.clear();
+      for (auto &&Buffer : Library) {
+        auto Driven = Forest.bestDriven(T, Buffer.R);
+        auto RAT = Driven.RAT - (Buffer.K + Buffer.R * Driven.Capacity);
+        Buffered.push_back(FrontierEntryTy{
+            .Capacity = Buffer.C,
+            .RAT = RAT,
+            .Record = DAG.addBuffer(Driven.Record, Buffer.C, RAT, Point, EId,
+                                    Buffer),
+        });
+      }
+      for (auto &&Entry : Buffered)
+        Forest.insert(T, Entry);
+    }
+    Frontiers[NId] = T;
+  }
+  throw std::runtime_error("graph has no root");
+}
+
+} // namespace algo
@@ -0,0 +1,516 @@
+#include "SoAFrontier.h"
+#include "TimingPolicy.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if (defined(__GNUC__) || defined(__clang__)) &&                               \
+    (defined(__x86_64__) || defined(__i386__))
+#define ALGO_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define ALGO_X86_KERNELS 0
+#endif
+
+using namespace algo;
+
+namespace {
+
+using RecordTy = const CandidateRecordTy *;
+using FixedTy = FixedNumeric::ValueTy;
+
+template <typename FloatTy>
+void addWireScalar(FloatTy *C, FloatTy *RAT, size_t Begin, size_t End,
+                   FloatTy ConstDelay, FloatTy DelayPerC, FloatTy AddC) {
+  using NumericT = typename NumericOf<FloatTy>::Ty;
+  for (size_t Idx = Begin; Idx != End; ++Idx) {
+    RAT[Idx] = NumericT::sub(RAT[Idx],
+                             NumericT::linear(ConstDelay, DelayPerC, C[Idx]));
+    C[Idx] = NumericT::add(C[Idx], AddC);
+  }
+}
+
+// Fixed-point kernels multiply unsigned and shift logically, which matches
+// FixedNumeric::mulWide for non-negative operands only. The bound is checked
+// on the last entry, the one with the largest capacity and delay, so the
+// kernels only have to catch a RAT that wraps around.
+bool fixedKernelsApply(const FixedTy *C, size_t Size, FixedTy ConstDelay,
+                       FixedTy DelayPerC, FixedTy AddC) {
+  if (ConstDelay < 0 || DelayPerC < 0 || AddC < 0 || C[0] < 0)
+    return false;
+  FixedNumeric::linear(ConstDelay, DelayPerC, C[Size - 1]);
+  FixedNumeric::add(C[Size - 1], AddC);
+  return true;
+}
+
+[[noreturn]] void throwRATOverflow() {
+  throw std::overflow_error("fixed-point timing value out of range");
+}
+
+// Entry Idx is not dominated by any entry before it. It either follows the
+// last kept entry or replaces it when capacities are equal.
+template <typename FloatTy>
+size_t keepEntry(FloatTy *C, FloatTy *RAT, RecordTy *Records, size_t Kept,
+                 size_t Idx) {
+  if (C[Idx] > C[Kept])
+    ++Kept;
+  C[Kept] = C[Idx];
+  RAT[Kept] = RAT[Idx];
+  Records[Kept] = Records[Idx];
+  return Kept;
+}
+
+// The last kept entry always holds the maximal RAT seen so far, so an entry
+// survives iff its RAT exceeds it.
+template <typename FloatTy>
+size_t pruneScalar(FloatTy *C, FloatTy *RAT, RecordTy *Records, size_t Kept,
+                   size_t Begin, size_t End) {
+  for (size_t Idx = Begin; Idx != End; ++Idx)
+    if (RAT[Idx] > RAT[Kept])
+      Kept = keepEntry(C, RAT, Records, Kept, Idx);
+  return Kept;
+}
+
+#if ALGO_X86_KERNELS
+
+__attribute__((target("sse2"))) void
+addWireSSE(float *C, float *RAT, size_t Size, float ConstDelay,
+           float DelayPerC, float AddC) {
+  auto A = _mm_set1_ps(ConstDelay);
+  auto B = _mm_set1_ps(DelayPerC);
+  auto D = _mm_set1_ps(AddC);
+  size_t Idx = 0;
+  for (; Idx + 4 <= Size; Idx += 4) {
+    auto CV = _mm_loadu_ps(C + Idx);
+    auto Delay = _mm_add_ps(A, _mm_mul_ps(B, CV));
+    _mm_storeu_ps(RAT + Idx, _mm_sub_ps(_mm_loadu_ps(RAT + Idx), Delay));
+    _mm_storeu_ps(C + Idx, _mm_add_ps(CV, D));
+  }
+  addWireScalar(C, RAT, Idx, Size, ConstDelay, DelayPerC, AddC);
+}
+
+__attribute__((target("avx2"))) void
+addWireAVX2(float *C, float *RAT, size_t Size, float ConstDelay,
+            float DelayPerC, float AddC) {
+  auto A = _mm256_set1_ps(ConstDelay);
+  auto B = _mm256_set1_ps(DelayPerC);
+  auto D = _mm256_set1_ps(AddC);
+  size_t Idx = 0;
+  for (; Idx + 8 <= Size; Idx += 8) {
+    auto CV = _mm256_loadu_ps(C + Idx);
+    auto Delay = _mm256_add_ps(A, _mm256_mul_ps(B, CV));
+    _mm256_storeu_ps(RAT + Idx,
+                     _mm256_sub_ps(_mm256_loadu_ps(RAT + Idx), Delay));
+    _mm256_storeu_ps(C + Idx, _mm256_add_ps(CV, D));
+  }
+  addWireScalar(C, RAT, Idx, Size, ConstDelay, DelayPerC, AddC);
+}
+
+// Same kernels on packed doubles.
+__attribute__((target("sse2"))) void
+addWireSSE(double *C, double *RAT, size_t Size, double ConstDelay,
+           double DelayPerC, double AddC) {
+  auto A = _mm_set1_pd(ConstDelay);
+  auto B = _mm_set1_pd(DelayPerC);
+  auto D = _mm_set1_pd(AddC);
+  size_t Idx = 0;
+  for (; Idx + 2 <= Size; Idx += 2) {
+    auto CV = _mm_loadu_pd(C + Idx);
+    auto Delay = _mm_add_pd(A, _mm_mul_pd(B, CV));
+    _mm_storeu_pd(RAT + Idx, _mm_sub_pd(_mm_loadu_pd(RAT + Idx), Delay));
+    _mm_storeu_pd(C + Idx, _mm_add_pd(CV, D));
+  }
+  addWireScalar(C, RAT, Idx, Size, ConstDelay, DelayPerC, AddC);
+}
+
+__attribute__((target("avx2"))) void
+addWireAVX2(double *C, double *RAT, size_t Size, double ConstDelay,
+            double DelayPerC, double AddC) {
+  auto A = _mm256_set1_pd(ConstDelay);
+  auto B = _mm256_set1_pd(DelayPerC);
+  auto D = _mm256_set1_pd(AddC);
+  size_t Idx = 0;
+  for (; Idx + 4 <= Size; Idx += 4) {
+    auto CV = _mm256_loadu_pd(C + Idx);
+    auto Delay = _mm256_add_pd(A, _mm256_mul_pd(B, CV));
+    _mm256_storeu_pd(RAT + Idx,
+                     _mm256_sub_pd(_mm256_loadu_pd(RAT + Idx), Delay));
+    _mm256_storeu_pd(C + Idx, _mm256_add_pd(CV, D));
+  }
+  addWireScalar(C, RAT, Idx, Size, ConstDelay, DelayPerC, AddC);
+}
+
+// Fixed-point kernels. Delays are non-negative, so a lane wrapped around iff
+// its RAT grew.
+__attribute__((target("sse2"))) void
+addWireSSE(FixedTy *C, FixedTy *RAT, size_t Size, FixedTy ConstDelay,
+           FixedTy DelayPerC, FixedTy AddC) {
+  auto A = _mm_set1_epi32(ConstDelay);
+  auto B = _mm_set1_epi32(DelayPerC);
+  auto D = _mm_set1_epi32(AddC);
+  auto Half = _mm_set1_epi64x(std::int64_t{1} << (FixedNumeric::FracBits - 1));
+  auto Low = _mm_set1_epi64x(0xFFFFFFFF);
+  auto Wrapped = _mm_setzero_si128();
+  size_t Idx = 0;
+  for (; Idx + 4 <= Size; Idx += 4) {
+    auto CV = _mm_loadu_si128(reinterpret_cast<const __m128i *>(C + Idx));
+    auto Even = _mm_mul_epu32(CV, B);
+    auto Odd = _mm_mul_epu32(_mm_srli_epi64(CV, 32), B);
+    Even = _mm_srli_epi64(_mm_add_epi64(Even, Half), FixedNumeric::FracBits);
+    Odd = _mm_srli_epi64(_mm_add_epi64(Odd, Half), FixedNumeric::FracBits);
+    auto Delay = _mm_add_epi32(
+        A, _mm_or_si128(_mm_and_si128(Even, Low), _mm_slli_epi64(Odd, 32)));
+    auto OldRAT = _mm_loadu_si128(reinterpret_cast<const __m128i *>(RAT + Idx));
+    auto NewRAT = _mm_sub_epi32(OldRAT, Delay);
+    Wrapped = _mm_or_si128(Wrapped, _mm_cmpgt_epi32(NewRAT, OldRAT));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(RAT + Idx), NewRAT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(C + Idx),
+                     _mm_add_epi32(CV, D));
+  }
+  if (_mm_movemask_epi8(Wrapped))
+    throwRATOverflow();
+  addWireScalar(C, RAT, Idx, Size, ConstDelay, DelayPerC, AddC);
+}
+
+__attribute__((target("avx2"))) void
+addWireAVX2(FixedTy *C, FixedTy *RAT, size_t Size, FixedTy ConstDelay,
+            FixedTy DelayPerC, FixedTy AddC) {
+  auto A = _mm256_set1_epi32(ConstDelay);
+  auto B = _mm256_set1_epi32(DelayPerC);
+  auto D = _mm256_set1_epi32(AddC);
+  auto Half =
+      _mm256_set1_epi64x(std::int64_t{1} << (FixedNumeric::FracBits - 1));
+  auto Low = _mm256_set1_epi64x(0xFFFFFFFF);
+  auto Wrapped = _mm256_setzero_si256();
+  size_t Idx = 0;
+  for (; Idx + 8 <= Size; Idx += 8) {
+    auto CV = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(C + Idx));
+    auto Even = _mm256_mul_epu32(CV, B);
+    auto Odd = _mm256_mul_epu32(_mm256_srli_epi64(CV, 32), B);
+    Even =
+        _mm256_srli_epi64(_mm256_add_epi64(Even, Half), FixedNumeric::FracBits);
+    Odd =
+        _mm256_srli_epi64(_mm256_add_epi64(Odd, Half), FixedNumeric::FracBits);
+    auto Delay = _mm256_add_epi32(
+        A, _mm256_or_si256(_mm256_and_si256(Even, Low),
+                           _mm256_slli_epi64(Odd, 32)));
+    auto OldRAT =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(RAT + Idx));
+    auto NewRAT = _mm256_sub_epi32(OldRAT, Delay);
+    Wrapped = _mm256_or_si256(Wrapped, _mm256_cmpgt_epi32(NewRAT, OldRAT));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(RAT + Idx), NewRAT);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(C + Idx),
+                        _mm256_add_epi32(CV, D));
+  }
+  if (_mm256_movemask_epi8(Wrapped))
+    throwRATOverflow();
+  addWireScalar(C, RAT, Idx, Size, ConstDelay, DelayPerC, AddC);
+}
+
+// Shifts lanes up by one, lane 0 is taken from Fill.
+__attribute__((target("sse2"))) inline __m128 shiftIn(__m128 V, __m128 Fill) {
+  auto Shifted = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(V), 4));
+  return _mm_move_ss(Shifted, Fill);
+}
+
+// Survivors of a block of four are found at once: the prefix maximum of the
+// block RATs, shifted by one lane and combined with the maximum before the
+// block, is what each entry has to beat. Only survivors are then moved one by
+// one. The scan is a chain of cross-lane shuffles, so wider registers buy
+// nothing here and AVX2 uses this kernel as well.
+__attribute__((target("sse2"))) size_t
+pruneSSE(float *C, float *RAT, RecordTy *Records, size_t Size) {
+  auto NegInf = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+  auto Max = _mm_set1_ps(RAT[0]);
+  size_t Kept = 0;
+  size_t Idx = 1;
+  for (; Idx + 4 <= Size; Idx += 4) {
+    auto V = _mm_loadu_ps(RAT + Idx);
+    auto Prefix = _mm_max_ps(V, shiftIn(V, NegInf));
+    Prefix = _mm_max_ps(Prefix, _mm_movelh_ps(NegInf, Prefix));
+    auto Before = _mm_max_ps(shiftIn(Prefix, Max), Max);
+    auto Mask = static_cast<unsigned>(
+        _mm_movemask_ps(_mm_cmpgt_ps(V, Before)));
+    for (; Mask; Mask &= Mask - 1)
+      Kept = keepEntry(C, RAT, Records, Kept, Idx + std::countr_zero(Mask));
+    Max = _mm_max_ps(Max, _mm_shuffle_ps(Prefix, Prefix, 0xFF));
+  }
+  return pruneScalar(C, RAT, Records, Kept, Idx, Size);
+}
+
+__attribute__((target("sse2"))) inline __m128i shiftIn(__m128i V,
+                                                       __m128i Fill) {
+  return _mm_castps_si128(shiftIn(_mm_castsi128_ps(V), _mm_castsi128_ps(Fill)));
+}
+
+// SSE2 has no signed 32-bit maximum.
+__attribute__((target("sse2"))) inline __m128i maxEpi32(__m128i Lhs,
+                                                        __m128i Rhs) {
+  auto Greater = _mm_cmpgt_epi32(Lhs, Rhs);
+  return _mm_or_si128(_mm_and_si128(Greater, Lhs),
+                      _mm_andnot_si128(Greater, Rhs));
+}
+
+// Same scan on fixed-point RATs.
+__attribute__((target("sse2"))) size_t
+pruneSSE(FixedTy *C, FixedTy *RAT, RecordTy *Records, size_t Size) {
+  auto Min = _mm_set1_epi32(std::numeric_limits<FixedTy>::min());
+  auto Max = _mm_set1_epi32(RAT[0]);
+  size_t Kept = 0;
+  size_t Idx = 1;
+  for (; Idx + 4 <= Size; Idx += 4) {
+    auto V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(RAT + Idx));
+    auto Prefix = maxEpi32(V, shiftIn(V, Min));
+    Prefix = maxEpi32(Prefix, _mm_unpacklo_epi64(Min, Prefix));
+    auto Before = maxEpi32(shiftIn(Prefix, Max), Max);
+    auto Mask = static_cast<unsigned>(
+        _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(V, Before))));
+    for (; Mask; Mask &= Mask - 1)
+      Kept = keepEntry(C, RAT, Records, Kept, Idx + std::countr_zero(Mask));
+    Max = maxEpi32(Max, _mm_shuffle_epi32(Prefix, 0xFF));
+  }
+  return pruneScalar(C, RAT, Records, Kept, Idx, Size);
+}
+
+#endif
+
+SIMDLevelTy detectSIMDLevel() {
+#if ALGO_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return SIMDLevelTy::AVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return SIMDLevelTy::SSE;
+#endif
+  return SIMDLevelTy::Scalar;
+}
+
+const SIMDLevelTy SupportedLevel = detectSIMDLevel();
+SIMDLevelTy CurrentLevel = SupportedLevel;
+
+} // namespace
+
+namespace algo {
+
+SIMDLevelTy getSIMDLevel() { return CurrentLevel; }
+
+SIMDLevelTy getSupportedSIMDLevel() { return SupportedLevel; }
+
+void setSIMDLevel(SIMDLevelTy Level) {
+  if (Level > SupportedLevel)
+    throw std::runtime_error(std::string{getSIMDLevelName(Level)} +
+                             " is not supported by this CPU");
+  CurrentLevel = Level;
+}
+
+SIMDLevelTy parseSIMDLevel(std::string_view Name) {
+  if (Name == "scalar")
+    return SIMDLevelTy::Scalar;
+  if (Name == "sse")
+    return SIMDLevelTy::SSE;
+  if (Name == "avx2")
+    return SIMDLevelTy::AVX2;
+  throw std::runtime_error("unknown SIMD level " + std::string{Name});
+}
+
+std::string_view getSIMDLevelName(SIMDLevelTy Level) {
+  switch (Level) {
+  case SIMDLevelTy::Scalar:
+    return "scalar";
+  case SIMDLevelTy::SSE:
+    return "sse";
+  case SIMDLevelTy::AVX2:
+    return "avx2";
+  }
+  return "unknown";
+}
+
+template <typename FloatT>
+void addWire(BasicSoAFrontier<FloatT> &Frontier, FloatT ConstDelay,
+             FloatT DelayPerC, FloatT AddC) {
+  auto *C = Frontier.Capacity.data();
+  auto *RAT = Frontier.RAT.data();
+  auto Size = Frontier.size();
+  if constexpr (std::is_same_v<FloatT, FixedTy>) {
+    if (!Size)
+      return;
+    if (!fixedKernelsApply(C, Size, ConstDelay, DelayPerC, AddC))
+      return addWireScalar(C, RAT, 0, Size, ConstDelay, DelayPerC, AddC);
+  }
+  switch (CurrentLevel) {
+#if ALGO_X86_KERNELS
+  case SIMDLevelTy::AVX2:
+    return addWireAVX2(C, RAT, Size, ConstDelay, DelayPerC, AddC);
+  case SIMDLevelTy::SSE:
+    return addWireSSE(C, RAT, Size, ConstDelay, DelayPerC, AddC);
+#endif
+  default:
+    return addWireScalar(C, RAT, 0, Size, ConstDelay, DelayPerC, AddC);
+  }
+}
+
+// Two doubles per register leave too little to scan for the shuffles to pay
+// off, so double frontiers are always pruned by the scalar sweep.
+template <typename FloatT>
+void pruneDominated(BasicSoAFrontier<FloatT> &Frontier) {
+  assert(Frontier.isSorted());
+
+  if (Frontier.empty())
+    return;
+
+  auto *C = Frontier.Capacity.data();
+  auto *RAT = Frontier.RAT.data();
+  auto *Records = Frontier.Records.data();
+  auto Size = Frontier.size();
+#if ALGO_X86_KERNELS
+  if constexpr (!std::is_same_v<FloatT, double>) {
+    if (CurrentLevel != SIMDLevelTy::Scalar) {
+      Frontier.resize(pruneSSE(C, RAT, Records, Size) + 1);
+      return;
+    }
+  }
+#endif
+  Frontier.resize(pruneScalar(C, RAT, Records, 0, 1, Size) + 1);
+}
+
+// Every kept entry covers the entries after it whose RAT is within the
+// tolerance, the next kept one is the last entry within the bucket of the
+// first uncovered entry, which covers the ones in between.
+template <typename FloatT>
+ApproximationLossTy<FloatT> pruneApproximate(BasicSoAFrontier<FloatT> &Frontier,
+                                             FloatT RATTolerance,
+                                             FloatT CapacityBucket) {
+  using NumericT = typename NumericOf<FloatT>::Ty;
+  assert(Frontier.isSorted());
+
+  auto &C = Frontier.Capacity;
+  auto &RAT = Frontier.RAT;
+  auto &Records = Frontier.Records;
+  auto Size = Frontier.size();
+  ApproximationLossTy<FloatT> Loss;
+  size_t Kept = 0;
+  for (size_t Idx = 0; Idx != Size;) {
+    C[Kept] = C[Idx];
+    RAT[Kept] = RAT[Idx];
+    Records[Kept] = Records[Idx];
+    ++Kept;
+
+    // Entries up to Uncovered lose RAT to the kept one, the next ones up to
+    // Idx lose capacity to the entry at Idx. RAT and capacity grow along
+    // the frontier, so the last entry of each run loses the most.
+    auto RATLimit = NumericT::add(RAT[Idx], RATTolerance);
+    auto Uncovered = Idx + 1;
+    while (Uncovered != Size && RAT[Uncovered] <= RATLimit)
+      ++Uncovered;
+    if (Uncovered != Idx + 1)
+      Loss.RAT =
+          std::max(Loss.RAT, NumericT::sub(RAT[Uncovered - 1], RAT[Idx]));
+    if (Uncovered == Size)
+      break;
+    auto CapacityLimit = NumericT::add(C[Uncovered], CapacityBucket);
+    Idx = Uncovered;
+    while (Idx + 1 != Size && C[Idx + 1] <= CapacityLimit)
+      ++Idx;
+    Loss.Capacity =
+        std::max(Loss.Capacity, NumericT::sub(C[Idx], C[Uncovered]));
+  }
+  Frontier.resize(Kept);
+  return Loss;
+}
+
+template <typename FloatT>
+void buildHull(const BasicSoAFrontier<FloatT> &Frontier, HullTy &Hull) {
+  assert(Frontier.isSorted());
+  Hull.clear();
+  for (size_t Idx = 0; Idx != Frontier.size(); ++Idx) {
+    while (Hull.size() > 1 && cross(Frontier[Hull[Hull.size() - 2]],
+                                    Frontier[Hull.back()], Frontier[Idx]) >= 0)
+      Hull.pop_back();
+    Hull.push_back(Idx);
+  }
+}
+
+template <typename FloatT>
+void mergeSorted(const BasicSoAFrontier<FloatT> &Lhs,
+                 const BasicFrontierTy<FloatT> &Rhs,
+                 BasicSoAFrontier<FloatT> &Merged) {
+  assert(Lhs.isSorted());
+  assert(std::is_sorted(Rhs.begin(), Rhs.end(), byCapacity));
+
+  Merged.clear();
+  Merged.reserve(Lhs.size() + Rhs.size());
+  size_t LhsIdx = 0;
+  auto RhsIt = Rhs.begin();
+  while (LhsIdx != Lhs.size() && RhsIt != Rhs.end()) {
+    if (RhsIt->Capacity < Lhs.Capacity[LhsIdx])
+      Merged.push_back(*RhsIt++);
+    else
+      Merged.push_back(Lhs[LhsIdx++]);
+  }
+  for (; LhsIdx != Lhs.size(); ++LhsIdx)
+    Merged.push_back(Lhs[LhsIdx]);
+  for (; RhsIt != Rhs.end(); ++RhsIt)
+    Merged.push_back(*RhsIt);
+}
+
+// Same walk as the one over FrontierTy.
+template <typename FloatT>
+BasicSoAFrontier<FloatT> mergeFrontiers(const BasicSoAFrontier<FloatT> &Lhs,
+                                        const BasicSoAFrontier<FloatT> &Rhs,
+                                        CandidateDAG &DAG) {
+  assert(Lhs.isSorted());
+  assert(Rhs.isSorted());
+
+  BasicSoAFrontier<FloatT> Merged;
+  Merged.reserve(Lhs.size() + Rhs.size());
+
+  size_t LhsIdx = 0;
+  size_t RhsIdx = 0;
+  while (LhsIdx != Lhs.size() && RhsIdx != Rhs.size()) {
+    auto LhsRAT = Lhs.RAT[LhsIdx];
+    auto RhsRAT = Rhs.RAT[RhsIdx];
+    auto Capacity = NumericOf<FloatT>::Ty::add(Lhs.Capacity[LhsIdx],
+                                               Rhs.Capacity[RhsIdx]);
+    // Rounding may collapse two sums into one capacity.
+    if (!Merged.empty() && Merged.Capacity.back() >= Capacity)
+      Merged.pop_back();
+    Merged.push_back({Capacity, std::min(LhsRAT, RhsRAT),
+                      DAG.join(Lhs.Records[LhsIdx], Rhs.Records[RhsIdx])});
+
+    if (LhsRAT < RhsRAT) {
+      ++LhsIdx;
+    } else if (RhsRAT < LhsRAT) {
+      ++RhsIdx;
+    } else {
+      ++LhsIdx;
+      ++RhsIdx;
+    }
+  }
+  return Merged;
+}
+
+#define INSTANTIATE_FRONTIER_KERNELS(FloatT)                                   \
+  template void addWire(BasicSoAFrontier<FloatT> &, FloatT, FloatT, FloatT);   \
+  template void pruneDominated(BasicSoAFrontier<FloatT> &);                    \
+  template ApproximationLossTy<FloatT> pruneApproximate(                       \
+      BasicSoAFrontier<FloatT> &, FloatT, FloatT);                             \
+  template void buildHull(const BasicSoAFrontier<FloatT> &, HullTy &);         \
+  template void mergeSorted(const BasicSoAFrontier<FloatT> &,                  \
+                            const BasicFrontierTy<FloatT> &,                   \
+                            BasicSoAFrontier<FloatT> &);                       \
+  template BasicSoAFrontier<FloatT> mergeFrontiers(                            \
+      const BasicSoAFrontier<FloatT> &, const BasicSoAFrontier<FloatT> &,      \
+      CandidateDAG &);
+
+INSTANTIATE_FRONTIER_KERNELS(float)
+INSTANTIATE_FRONTIER_KERNELS(double)
+INSTANTIATE_FRONTIER_KERNELS(FixedTy)
+
+#undef INSTANTIATE_FRONTIER_KERNELS
+
+} // namespace algo
@@ -101,10 +101,10 @@ void insertSolution(const SolutionTy &Solution, RCGraphTy &G) {
     // Fixing nodes
     std::vector<NodeIdTy> Nodes;
     Nodes.push_back(First);
-    const Module &M = G.getAttrs().getModule(ModuleKind::Buffer);
     for (auto &&S : Solutions) {
+      assert(S.Buffer && "Candidate without buffer");
       auto Node = NodeTy{.Kind = NodeKindTy::Buffer,
-                         .Name = M.Name,
+                         .Name = S.Buffer->Name,
                          .P = S.P,
                          .Capacity = S.Capacity,
                          .RAT = S.RAT};
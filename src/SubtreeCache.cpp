@@ -0,0 +1,51 @@
+#include "SubtreeCache.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+namespace algo {
+
+size_t SubtreeCache::KeyHashTy::operator()(const KeyTy &Key) const {
+  std::uint64_t Hash = Key.size();
+  for (auto Word : Key) {
+    Hash = (Hash ^ Word) * 0x9E3779B97F4A7C15ull;
+    Hash ^= Hash >> 32;
+  }
+  return Hash;
+}
+
+SubtreeCacheStatsTy SubtreeCache::getStats() const {
+  std::shared_lock Guard{Mutex};
+  return {Ids.size(), NumFrontiers, Hits.load(std::memory_order_relaxed),
+          Bytes};
+}
+
+static bool sameModule(const Module &Lhs, const Module &Rhs) {
+  return Lhs.Kind == Rhs.Kind && Lhs.Name == Rhs.Name && Lhs.R == Rhs.R &&
+         Lhs.C == Rhs.C && Lhs.K == Rhs.K;
+}
+
+void SubtreeCache::bind(const std::type_info &EngineTy, const Config &Cfg,
+                        const CandidatePolicyTy &Policy,
+                        const ApproximationTy &Approx) {
+  const auto &Buffers = Cfg.getModules(ModuleKind::Buffer);
+  if (!Engine) {
+    Engine = &EngineTy;
+    Tech = Cfg.getTechnology();
+    Library = Buffers;
+    Candidates = Policy;
+    Approximation = Approx;
+    return;
+  }
+  const auto &NetTech = Cfg.getTechnology();
+  if (*Engine != EngineTy || NetTech.UnitR != Tech.UnitR ||
+      NetTech.UnitC != Tech.UnitC || !(Policy == Candidates) ||
+      !(Approx == Approximation) ||
+      !std::equal(Buffers.begin(), Buffers.end(), Library.begin(),
+                  Library.end(), sameModule))
+    throw std::runtime_error(
+        "subtree cache is shared by runs with different settings");
+}
+
+} // namespace algo
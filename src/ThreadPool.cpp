@@ -0,0 +1,115 @@
+#include "ThreadPool.h"
+
+#include <utility>
+
+namespace algo {
+
+namespace {
+
+struct WorkerIdTy {
+  const ThreadPool *Pool = nullptr;
+  unsigned Idx = 0;
+};
+
+thread_local WorkerIdTy CurrentWorker;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned Threads) {
+  if (Threads == 0)
+    Threads = 1;
+  for (unsigned Idx = 0; Idx != Threads; ++Idx)
+    Queues.push_back(std::make_unique<QueueTy>());
+  for (unsigned Idx = 0; Idx != Threads; ++Idx)
+    Workers.emplace_back([this, Idx] { run(Idx); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> Guard{SleepLock};
+    Stop = true;
+  }
+  WakeUp.notify_all();
+  for (auto &Worker : Workers)
+    Worker.join();
+}
+
+unsigned ThreadPool::currentWorker() const {
+  return CurrentWorker.Pool == this ? CurrentWorker.Idx : size();
+}
+
+void ThreadPool::submit(TaskTy Task) {
+  auto Worker = currentWorker();
+  if (Worker == size())
+    Worker = NextQueue++ % size();
+  {
+    std::lock_guard<std::mutex> Guard{SleepLock};
+    ++Queued;
+    ++Unfinished;
+  }
+  {
+    auto &Queue = *Queues[Worker];
+    std::lock_guard<std::mutex> Guard{Queue.Lock};
+    Queue.Tasks.push_back(std::move(Task));
+  }
+  WakeUp.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> Guard{SleepLock};
+  Finished.wait(Guard, [this] { return Unfinished == 0; });
+  if (Error)
+    std::rethrow_exception(std::exchange(Error, nullptr));
+}
+
+bool ThreadPool::tryPop(unsigned Worker, TaskTy &Task) {
+  {
+    auto &Own = *Queues[Worker];
+    std::lock_guard<std::mutex> Guard{Own.Lock};
+    if (!Own.Tasks.empty()) {
+      Task = std::move(Own.Tasks.back());
+      Own.Tasks.pop_back();
+      return true;
+    }
+  }
+  for (unsigned Offset = 1; Offset != size(); ++Offset) {
+    auto &Victim = *Queues[(Worker + Offset) % size()];
+    std::lock_guard<std::mutex> Guard{Victim.Lock};
+    if (!Victim.Tasks.empty()) {
+      Task = std::move(Victim.Tasks.front());
+      Victim.Tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::run(unsigned Worker) {
+  CurrentWorker = WorkerIdTy{this, Worker};
+  while (true) {
+    {
+      std::unique_lock<std::mutex> Guard{SleepLock};
+      WakeUp.wait(Guard, [this] { return Queued != 0 || Stop; });
+      if (Queued == 0)
+        return;
+      --Queued;
+    }
+    // A task is reserved for this worker, it may still be in flight to its
+    // queue, so keep looking until it is there.
+    TaskTy Task;
+    while (!tryPop(Worker, Task))
+      std::this_thread::yield();
+    try {
+      Task();
+    } catch (...) {
+      std::lock_guard<std::mutex> Guard{SleepLock};
+      if (!Error)
+        Error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> Guard{SleepLock};
+    if (--Unfinished == 0)
+      Finished.notify_all();
+  }
+}
+
+} // namespace algo
@@ -0,0 +1,138 @@
+#include "BufferAlgorithm.h"
+#include "Config.h"
+#include "RCGraph.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+// Edits sinks and edges of a net at random, solves it again with
+// IncrementalBufferInsertion after every round of edits and compares the
+// result with the one of bufferInsertion on the edited net. Rounds go on
+// until the incremental solver has compacted its records twice.
+//
+//   CheckIncremental <technology_file_name>.json <test_name>.json
+
+using namespace algo;
+
+// Appends P to Points unless it repeats the last point.
+static void appendPoint(PointsTy &Points, PointTy P) {
+  if (Points.empty() || !(Points.back() == P))
+    Points.push_back(P);
+}
+
+static bool sameSolution(const SolutionTy &Lhs, const SolutionTy &Rhs) {
+  auto Same = [](const CandidateTy &L, const CandidateTy &R) {
+    return L.Capacity == R.Capacity && L.RAT == R.RAT && L.P == R.P &&
+           L.EId == R.EId && L.HasBuffer == R.HasBuffer && L.Buffer == R.Buffer;
+  };
+  return std::equal(Lhs.begin(), Lhs.end(), Rhs.begin(), Rhs.end(), Same);
+}
+
+static void checkIncremental(const Config &Cfg, const std::string &TestFile,
+                             const CandidatePolicyTy &Candidates) {
+  constexpr size_t MinRounds = 16;
+  constexpr size_t MaxRounds = 1 << 16;
+  constexpr size_t MinCompactions = 2;
+
+  auto G = loadRCGraph(TestFile);
+  G.setAttrs(Config{Cfg});
+  const auto Original = G;
+
+  std::vector<NodeTy::NodeIdTy> Sinks;
+  std::vector<EdgeTy::EdgeIdTy> Edges;
+  for (NodeTy::NodeIdTy NId = 0; NId != G.getNodeIdBound(); ++NId) {
+    if (G.getNode(NId).Kind == NodeKindTy::Point)
+      Sinks.push_back(NId);
+    if (NId != G.getRoot())
+      Edges.push_back(G.getParent(NId));
+  }
+  if (Sinks.empty() || Edges.empty())
+    throw std::runtime_error(TestFile + " has no sinks to edit");
+
+  // Fixed seed, so that a failing round can be replayed.
+  std::mt19937 Rand{0};
+  auto pick = [&](const auto &Ids) {
+    return Ids[std::uniform_int_distribution<size_t>{0, Ids.size() - 1}(Rand)];
+  };
+  auto scale = [&](NodeTy::FloatTy Value) {
+    return Value * std::uniform_real_distribution<NodeTy::FloatTy>{0.5, 2}(Rand);
+  };
+  auto upTo = [&](PointTy::CoordTy Max) {
+    return std::uniform_int_distribution<PointTy::CoordTy>{0, Max}(Rand);
+  };
+
+  IncrementalBufferInsertion<> Incremental{G, Candidates};
+  size_t Compactions = 0;
+  size_t Resets = 0;
+  size_t Round = 0;
+  for (; Round != MaxRounds; ++Round) {
+    if (Round >= MinRounds && Compactions >= MinCompactions)
+      break;
+    if (Round != 0) {
+      auto SinkId = pick(Sinks);
+      const auto &Sink = Original.getNode(SinkId);
+      Incremental.setSink(SinkId, scale(Sink.Capacity), scale(Sink.RAT));
+
+      // A detour of a random height whose horizontal run is split into a
+      // random number of pieces, so that edges both grow and shrink.
+      auto EId = pick(Edges);
+      auto First = G.getNode(G.getEdgeNodeFirst(EId)).P;
+      auto Last = G.getNode(G.getEdgeNodeLast(EId)).P;
+      auto Detour = upTo(8);
+      auto Pieces = upTo(6) + 1;
+      PointsTy Points;
+      appendPoint(Points, First);
+      for (PointTy::CoordTy Piece = 0; Piece != Pieces; ++Piece)
+        appendPoint(Points, {First.X + (Last.X - First.X) * Piece / Pieces,
+                             First.Y + Detour});
+      appendPoint(Points, {Last.X, First.Y + Detour});
+      appendPoint(Points, Last);
+      Incremental.setEdgePoints(EId, std::move(Points));
+
+      auto ModifiedId = pick(Sinks);
+      G.getNode(ModifiedId).RAT = scale(Original.getNode(ModifiedId).RAT);
+      Incremental.markModified(ModifiedId);
+    }
+
+    EngineStatsTy Stats;
+    auto Actual = Incremental.solve(&Stats);
+    if (Stats.Records.Resets > Resets)
+      ++Compactions;
+    Resets = Stats.Records.Resets;
+
+    auto Expected = bufferInsertion<>(G, Candidates);
+    if (!sameSolution(Actual, Expected))
+      throw std::runtime_error(
+          "incremental solution differs from bufferInsertion in round " +
+          std::to_string(Round) + ": RAT " +
+          std::to_string(Actual.back().RAT) + " instead of " +
+          std::to_string(Expected.back().RAT));
+  }
+  if (Compactions < MinCompactions)
+    throw std::runtime_error("records were compacted " +
+                             std::to_string(Compactions) + " times in " +
+                             std::to_string(Round) + " rounds");
+  std::cout << TestFile << ": Rounds = " << Round
+            << ", Compactions = " << Compactions << std::endl;
+}
+
+int main(int argc, const char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " <technology_file_name>.json <test_name>.json" << std::endl;
+    return 1;
+  }
+  try {
+    std::ifstream CfgIS{argv[1]};
+    auto Cfg = readConfig(CfgIS);
+    // Every candidate point, and a single one per edge.
+    checkIncremental(Cfg, argv[2], {});
+    checkIncremental(Cfg, argv[2], CandidatePolicyTy::maxPerEdge(1));
+    return 0;
+  } catch (const std::exception &E) {
+    std::cerr << E.what() << std::endl;
+    return 1;
+  }
+}